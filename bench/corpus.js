@@ -0,0 +1,208 @@
+// Deterministic synthetic feed corpus for the benchmarks.
+// The same seed always gives the same feeds so that the
+// results of different builds can be compared.
+//
+// Usage: node bench/corpus name dir [seed]
+// writes the feeds of the corpus into the directory.
+
+var fs = require('fs');
+var path = require('path');
+
+// Small and fast PRNG (mulberry32).
+
+function random(seed) {
+    var state = seed >>> 0;
+    return function() {
+        state = (state + 0x6D2B79F5) >>> 0;
+        var t = state;
+        t = Math.imul(t ^ (t >>> 15), t | 1);
+        t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+        return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+    };
+}
+
+var WORDS = [
+    'market', 'report', 'city', 'council', 'update', 'release', 'weather',
+    'science', 'energy', 'election', 'software', 'review', 'football',
+    'health', 'travel', 'music', 'policy', 'research', 'network', 'design'
+];
+
+var NON_ASCII_WORDS = [
+    'päevauudised', 'õhtu', 'Zürich', 'ελληνικά', 'новости', 'français',
+    '日本語', 'ニュース', '中文', '한국어', 'español', 'ümberkorraldus',
+    'naïve', 'Ångström', 'emoji 😀', 'façade'
+];
+
+// Generator state: PRNG and word list.
+
+function Generator(seed, words) {
+    this.random = random(seed);
+    this.words = words || WORDS;
+}
+
+Generator.prototype.int = function(min, max) {
+    return min + Math.floor(this.random() * (max - min + 1));
+};
+
+Generator.prototype.phrase = function(count) {
+    var result = [];
+    for (var i = 0; i < count; i++) {
+        result.push(this.words[this.int(0, this.words.length - 1)]);
+    }
+    return result.join(' ');
+};
+
+Generator.prototype.sentence = function(min, max) {
+    return this.phrase(this.int(min, max));
+};
+
+Generator.prototype.paragraphs = function(count) {
+    var result = [];
+    for (var i = 0; i < count; i++) {
+        result.push('<p>' + this.sentence(20, 60) + '.</p>');
+    }
+    return result.join('\n');
+};
+
+// Escapes text for XML element content.
+
+function escape(text) {
+    return text.replace(/&/g, '&amp;').replace(/</g, '&lt;').replace(/>/g, '&gt;');
+}
+
+function date(index) {
+    return new Date(Date.UTC(2019, 0, 1) + index * 3600000).toUTCString();
+}
+
+// RSS 2.0 feed. Options: items, html (escaped or CDATA),
+// paragraphs per description, podcast extensions.
+
+function rss(generator, options) {
+    var parts = [];
+    parts.push('<?xml version="1.0" encoding="UTF-8"?>\n');
+    parts.push('<rss version="2.0"');
+    if (options.podcast) {
+        parts.push(' xmlns:itunes="http://www.itunes.com/dtds/podcast-1.0.dtd"');
+        parts.push(' xmlns:media="http://search.yahoo.com/mrss/"');
+    }
+    parts.push('>\n<channel>\n');
+    parts.push('<title>' + escape(generator.sentence(2, 5)) + '</title>\n');
+    parts.push('<link>http://example.com/</link>\n');
+    parts.push('<description>' + escape(generator.sentence(5, 15)) + '</description>\n');
+    if (options.podcast) {
+        parts.push('<itunes:author>' + escape(generator.sentence(2, 3)) + '</itunes:author>\n');
+        parts.push('<itunes:explicit>no</itunes:explicit>\n');
+        parts.push('<itunes:image href="http://example.com/cover.jpg"/>\n');
+        parts.push('<itunes:category text="Technology"/>\n');
+    }
+    for (var i = 0; i < options.items; i++) {
+        var html = generator.paragraphs(options.paragraphs);
+        parts.push('<item>\n');
+        parts.push('<title>' + escape(generator.sentence(4, 10)) + '</title>\n');
+        parts.push('<link>http://example.com/items/' + i + '</link>\n');
+        parts.push('<guid isPermaLink="false">item-' + i + '</guid>\n');
+        parts.push('<pubDate>' + date(i) + '</pubDate>\n');
+        parts.push('<category>' + escape(generator.sentence(1, 2)) + '</category>\n');
+        if (options.cdata) {
+            parts.push('<description><![CDATA[' + html + ']]></description>\n');
+        } else {
+            parts.push('<description>' + escape(html) + '</description>\n');
+        }
+        if (options.podcast) {
+            parts.push('<enclosure url="http://example.com/episodes/' + i +
+                '.mp3" length="' + generator.int(1000000, 90000000) + '" type="audio/mpeg"/>\n');
+            parts.push('<itunes:duration>' + generator.int(10, 90) + ':00</itunes:duration>\n');
+            parts.push('<itunes:episode>' + (i + 1) + '</itunes:episode>\n');
+            parts.push('<itunes:summary>' + escape(generator.sentence(20, 40)) + '</itunes:summary>\n');
+            parts.push('<itunes:keywords>' + escape(generator.sentence(3, 6)) + '</itunes:keywords>\n');
+            parts.push('<media:content url="http://example.com/episodes/' + i +
+                '.mp4" medium="video" duration="' + generator.int(600, 5400) + '"/>\n');
+            parts.push('<media:thumbnail url="http://example.com/thumbs/' + i + '.jpg"/>\n');
+        }
+        parts.push('</item>\n');
+    }
+    parts.push('</channel>\n</rss>\n');
+    return parts.join('');
+}
+
+// Atom feed with HTML content.
+
+function atom(generator, options) {
+    var parts = [];
+    parts.push('<?xml version="1.0" encoding="UTF-8"?>\n');
+    parts.push('<feed xmlns="http://www.w3.org/2005/Atom">\n');
+    parts.push('<title>' + escape(generator.sentence(2, 5)) + '</title>\n');
+    parts.push('<id>urn:example:feed</id>\n');
+    parts.push('<updated>2019-01-01T00:00:00Z</updated>\n');
+    parts.push('<link href="http://example.com/"/>\n');
+    for (var i = 0; i < options.items; i++) {
+        parts.push('<entry>\n');
+        parts.push('<title>' + escape(generator.sentence(4, 10)) + '</title>\n');
+        parts.push('<id>urn:example:entry:' + i + '</id>\n');
+        parts.push('<link href="http://example.com/entries/' + i + '"/>\n');
+        parts.push('<updated>' + new Date(Date.UTC(2019, 0, 1) + i * 3600000).toISOString() + '</updated>\n');
+        parts.push('<author><name>' + escape(generator.sentence(2, 3)) + '</name></author>\n');
+        parts.push('<summary>' + escape(generator.sentence(10, 30)) + '</summary>\n');
+        parts.push('<content type="html">' + escape(generator.paragraphs(options.paragraphs)) + '</content>\n');
+        parts.push('</entry>\n');
+    }
+    parts.push('</feed>\n');
+    return parts.join('');
+}
+
+// The corpora. Each one is a list of feeds that
+// are parsed one after another.
+
+var CORPORA = {
+    // Typical news feeds: small, a few items each.
+    news: function(seed) {
+        var generator = new Generator(seed);
+        var feeds = [];
+        for (var i = 0; i < 50; i++) {
+            var options = { items: generator.int(10, 30), paragraphs: 1 };
+            feeds.push(i % 2 === 0 ? rss(generator, options) : atom(generator, options));
+        }
+        return feeds;
+    },
+    // Large archive feed.
+    archive: function(seed) {
+        return [rss(new Generator(seed), { items: 5000, paragraphs: 2 })];
+    },
+    // Long HTML content in CDATA sections.
+    cdata: function(seed) {
+        return [rss(new Generator(seed), { items: 200, paragraphs: 20, cdata: true })];
+    },
+    // Podcast feed with many extension elements.
+    podcast: function(seed) {
+        return [rss(new Generator(seed), { items: 500, paragraphs: 1, podcast: true })];
+    },
+    // Mostly non-ASCII text.
+    nonascii: function(seed) {
+        var generator = new Generator(seed, NON_ASCII_WORDS);
+        return [atom(generator, { items: 500, paragraphs: 3 })];
+    }
+};
+
+exports.names = Object.keys(CORPORA);
+
+// generate(name, [seed]) returns the list of feeds.
+
+exports.generate = function(name, seed) {
+    if (!CORPORA.hasOwnProperty(name)) {
+        throw new Error('Unknown corpus: ' + name);
+    }
+    return CORPORA[name](typeof seed === 'undefined' ? 1 : seed);
+};
+
+if (require.main === module) {
+    var name = process.argv[2];
+    var dir = process.argv[3];
+    if (!name || !dir) {
+        console.error('Usage: node bench/corpus name dir [seed]');
+        process.exit(2);
+    }
+    var seed = process.argv[4] ? parseInt(process.argv[4], 10) : 1;
+    exports.generate(name, seed).forEach(function(xml, i) {
+        fs.writeFileSync(path.join(dir, name + '-' + i + '.xml'), xml);
+    });
+}
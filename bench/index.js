@@ -0,0 +1,147 @@
+// Benchmark runner. Parses each corpus with every
+// combination of the content and extensions options.
+//
+// Usage: node bench [--corpus=name,...] [--time=ms] [--seed=n]
+
+var fastFeed = require('..');
+var corpus = require('./corpus');
+
+function parseArgs(argv) {
+    var args = { corpus: corpus.names, time: 2000, seed: 1 };
+    argv.forEach(function(arg) {
+        var match = /^--(\w+)=(.*)$/.exec(arg);
+        if (!match) {
+            throw new Error('Invalid argument: ' + arg);
+        }
+        if (match[1] === 'corpus') {
+            args.corpus = match[2].split(',');
+        } else if (match[1] === 'time') {
+            args.time = parseInt(match[2], 10);
+        } else if (match[1] === 'seed') {
+            args.seed = parseInt(match[2], 10);
+        } else {
+            throw new Error('Unknown argument: ' + arg);
+        }
+    });
+    return args;
+}
+
+// Nanoseconds since an arbitrary point.
+
+function now() {
+    var time = process.hrtime();
+    return time[0] * 1e9 + time[1];
+}
+
+function percentile(sorted, p) {
+    var index = Math.min(sorted.length - 1, Math.ceil(p * sorted.length) - 1);
+    return sorted[Math.max(0, index)];
+}
+
+// Runs the feeds through the parser until the given
+// time has passed. One sample is the time to parse
+// one feed.
+
+function run(feeds, options, time) {
+    var samples = [];
+    var bytes = 0;
+    var items = 0;
+    var start = now();
+    var i = 0;
+    while (now() - start < time * 1e6 || samples.length < 10) {
+        var feed = feeds[i++ % feeds.length];
+        var before = now();
+        fastFeed.parse(feed.buffer, options);
+        samples.push(now() - before);
+        bytes += feed.buffer.length;
+        items += feed.items;
+    }
+    var total = samples.reduce(function(sum, sample) { return sum + sample; }, 0);
+    samples.sort(function(a, b) { return a - b; });
+    return {
+        mbs: bytes / 1048576 / (total / 1e9),
+        items: items / (total / 1e9),
+        p50: percentile(samples, 0.5),
+        p99: percentile(samples, 0.99)
+    };
+}
+
+// Mean time of each phase from the stats option.
+// Measured in a separate pass because the stats
+// add a walk over the document, which would be
+// included in the samples of run.
+
+function phases(feeds, options, time) {
+    var statsOptions = { content: options.content, extensions: options.extensions, stats: true };
+    var parse = 0;
+    var extract = 0;
+    var build = 0;
+    var count = 0;
+    var start = now();
+    while (now() - start < time * 1e6 || count < 10) {
+        var stats = fastFeed.parse(feeds[count++ % feeds.length].buffer, statsOptions).stats;
+        parse += stats.parseNs;
+        extract += stats.extractNs;
+        build += stats.buildNs;
+    }
+    return {
+        parse: parse / count,
+        extract: extract / count,
+        build: build / count
+    };
+}
+
+function pad(value, width) {
+    var text = String(value);
+    while (text.length < width) {
+        text = ' ' + text;
+    }
+    return text;
+}
+
+function ms(ns) {
+    return (ns / 1e6).toFixed(3);
+}
+
+var COMBINATIONS = [
+    { content: false, extensions: false },
+    { content: true, extensions: false },
+    { content: false, extensions: true },
+    { content: true, extensions: true }
+];
+
+var COLUMNS = [
+    ['corpus', 9], ['content', 8], ['ext', 6], ['MB/s', 9], ['items/s', 10],
+    ['p50 ms', 9], ['p99 ms', 9], ['parse ms', 9], ['extract ms', 10], ['build ms', 9]
+];
+
+function row(values) {
+    return values.map(function(value, i) {
+        return pad(value, COLUMNS[i][1]);
+    }).join(' ');
+}
+
+function main() {
+    var args = parseArgs(process.argv.slice(2));
+    console.log('node ' + process.version + ', seed ' + args.seed + ', ' + args.time + ' ms per case');
+    console.log(row(COLUMNS.map(function(column) { return column[0]; })));
+    args.corpus.forEach(function(name) {
+        var feeds = corpus.generate(name, args.seed).map(function(xml) {
+            var buffer = Buffer.from(xml);
+            return { buffer: buffer, items: fastFeed.parse(buffer).items.length };
+        });
+        COMBINATIONS.forEach(function(options) {
+            // Warm up.
+            run(feeds, options, args.time / 10);
+            var result = run(feeds, options, args.time);
+            var split = phases(feeds, options, args.time / 4);
+            console.log(row([
+                name, options.content, options.extensions,
+                result.mbs.toFixed(1), Math.round(result.items),
+                ms(result.p50), ms(result.p99), ms(split.parse), ms(split.extract), ms(split.build)
+            ]));
+        });
+    });
+}
+
+main();
@@ -0,0 +1,261 @@
+// Reader of the binary result (the binary option).
+// Fields are decoded from the buffer on access. The
+// layout is described in README.md.
+
+var MAGIC = 0x31424646;
+var VERSION = 1;
+var NONE = 0xFFFFFFFF;
+var HEADER_SIZE = 40;
+var ITEM_SIZE = 128;
+
+var FEED_FIELDS = ['title', 'id', 'link', 'description', 'author', 'author_uri', 'author_email'];
+
+var ITEM_FIELDS = ['id', 'title', 'link', 'date_raw', 'description', 'summary', 'content',
+    'author', 'author_uri', 'author_email'];
+
+var LINK_FIELDS = ['rel', 'href', 'type', 'hreflang', 'title', 'length', 'text'];
+
+// BinaryFeed(buffer). The buffer is an ArrayBuffer
+// or a view of it.
+
+function BinaryFeed(buffer) {
+    var offset = 0;
+    var length = buffer.byteLength;
+    if (ArrayBuffer.isView(buffer)) {
+        offset = buffer.byteOffset;
+        buffer = buffer.buffer;
+    }
+    this.view = new DataView(buffer, offset, length);
+    this.bytes = Buffer.from(buffer, offset, length);
+    if (length < HEADER_SIZE || this.view.getUint32(0, true) !== MAGIC) {
+        throw new Error('Invalid binary feed.');
+    }
+    if (this.view.getUint32(4, true) !== VERSION) {
+        throw new Error('Unsupported binary feed version.');
+    }
+    this.type = this.view.getUint32(8, true) & 1 ? 'atom' : 'rss';
+    this.length = this.view.getUint32(12, true);
+    this.itemsOffset = this.view.getUint32(16, true);
+    this.listsOffset = this.view.getUint32(20, true);
+    this.heapOffset = this.view.getUint32(24, true);
+    this._items = undefined;
+}
+
+// Decodes the string reference at the position.
+
+BinaryFeed.prototype._text = function(pos) {
+    var start = this.view.getUint32(pos, true);
+    if (start === NONE) {
+        return undefined;
+    }
+    start += this.heapOffset;
+    return this.bytes.toString('utf8', start, start + this.view.getUint32(pos + 4, true));
+};
+
+// Position of the list entry.
+
+BinaryFeed.prototype._list = function(index) {
+    return this.listsOffset + index * 4;
+};
+
+BinaryFeed.prototype._extensions = function(index) {
+    if (index === NONE) {
+        return undefined;
+    }
+    var pos = this._list(index);
+    var count = this.view.getUint32(pos, true);
+    var extensions = [];
+    pos += 4;
+    for (var i = 0; i < count; i++) {
+        var extension = {};
+        setValue(extension, 'name', this._text(pos));
+        setValue(extension, 'value', this._text(pos + 8));
+        var attributeCount = this.view.getUint32(pos + 16, true);
+        pos += 20;
+        if (attributeCount > 0) {
+            extension.attributes = {};
+            for (var j = 0; j < attributeCount; j++) {
+                setValue(extension.attributes, this._text(pos), this._text(pos + 8));
+                pos += 16;
+            }
+        }
+        extensions.push(extension);
+    }
+    return extensions;
+};
+
+FEED_FIELDS.forEach(function(name, i) {
+    Object.defineProperty(BinaryFeed.prototype, name, {
+        get: function() {
+            return this._text(HEADER_SIZE + i * 8);
+        }
+    });
+});
+
+Object.defineProperty(BinaryFeed.prototype, 'items', {
+    get: function() {
+        if (typeof this._items === 'undefined') {
+            this._items = [];
+            for (var i = 0; i < this.length; i++) {
+                this._items.push(new BinaryItem(this, this.itemsOffset + i * ITEM_SIZE));
+            }
+        }
+        return this._items;
+    }
+});
+
+Object.defineProperty(BinaryFeed.prototype, 'extensions', {
+    get: function() {
+        return this._extensions(this.view.getUint32(32, true));
+    }
+});
+
+Object.defineProperty(BinaryFeed.prototype, 'warnings', {
+    get: function() {
+        var index = this.view.getUint32(36, true);
+        var warnings = [];
+        if (index !== NONE) {
+            var pos = this._list(index);
+            var count = this.view.getUint32(pos, true);
+            for (var i = 0; i < count; i++) {
+                warnings.push(this._text(pos + 4 + i * 8));
+            }
+        }
+        return warnings;
+    }
+});
+
+// Decodes the whole feed into the same
+// object as parse() returns.
+
+BinaryFeed.prototype.toObject = function() {
+    var object = { type: this.type };
+    var names = this.type === 'atom' ?
+        ['title', 'id', 'link', 'author', 'author_uri', 'author_email'] :
+        ['title', 'description', 'link', 'author'];
+    copy(this, object, names);
+    setValue(object, 'extensions', this.extensions);
+    object.items = this.items.map(function(item) {
+        return item.toObject();
+    });
+    return object;
+};
+
+// Item in the binary feed.
+
+function BinaryItem(feed, pos) {
+    this.feed = feed;
+    this.pos = pos;
+}
+
+ITEM_FIELDS.forEach(function(name, i) {
+    Object.defineProperty(BinaryItem.prototype, name, {
+        get: function() {
+            return this.feed._text(this.pos + i * 8);
+        }
+    });
+});
+
+// Natively parsed dates are stored as the time.
+// Others are parsed with Date.parse like parse()
+// does.
+
+Object.defineProperty(BinaryItem.prototype, 'date', {
+    get: function() {
+        var time = this.feed.view.getFloat64(this.pos + 96, true);
+        if (isNaN(time)) {
+            var raw = this.date_raw;
+            if (typeof raw === 'undefined') {
+                return undefined;
+            }
+            time = Date.parse(raw);
+        }
+        return new Date(time);
+    }
+});
+
+Object.defineProperty(BinaryItem.prototype, 'enclosure', {
+    get: function() {
+        var view = this.feed.view;
+        if (!(view.getUint32(this.pos + 112, true) & 1)) {
+            return undefined;
+        }
+        var enclosure = {};
+        var length = view.getFloat64(this.pos + 104, true);
+        if (!isNaN(length)) {
+            enclosure.length = length;
+        }
+        setValue(enclosure, 'type', this.feed._text(this.pos + 88));
+        setValue(enclosure, 'url', this.feed._text(this.pos + 80));
+        return enclosure;
+    }
+});
+
+Object.defineProperty(BinaryItem.prototype, 'categories', {
+    get: function() {
+        var index = this.feed.view.getUint32(this.pos + 116, true);
+        if (index === NONE) {
+            return undefined;
+        }
+        var pos = this.feed._list(index);
+        var count = this.feed.view.getUint32(pos, true);
+        var categories = [];
+        for (var i = 0; i < count; i++) {
+            categories.push({ name: this.feed._text(pos + 4 + i * 8) });
+        }
+        return categories;
+    }
+});
+
+Object.defineProperty(BinaryItem.prototype, 'links', {
+    get: function() {
+        var index = this.feed.view.getUint32(this.pos + 120, true);
+        if (index === NONE) {
+            return this.feed.type === 'atom' ? [] : undefined;
+        }
+        var pos = this.feed._list(index);
+        var count = this.feed.view.getUint32(pos, true);
+        var links = [];
+        pos += 4;
+        for (var i = 0; i < count; i++) {
+            var link = {};
+            for (var j = 0; j < LINK_FIELDS.length; j++) {
+                setValue(link, LINK_FIELDS[j], this.feed._text(pos));
+                pos += 8;
+            }
+            links.push(link);
+        }
+        return links;
+    }
+});
+
+Object.defineProperty(BinaryItem.prototype, 'extensions', {
+    get: function() {
+        return this.feed._extensions(this.feed.view.getUint32(this.pos + 124, true));
+    }
+});
+
+BinaryItem.prototype.toObject = function() {
+    var object = {};
+    var names = this.feed.type === 'atom' ?
+        ['id', 'links', 'title', 'date', 'author', 'author_uri', 'author_email', 'summary',
+            'content', 'extensions', 'link'] :
+        ['categories', 'id', 'link', 'date', 'title', 'author', 'enclosure', 'description',
+            'content', 'extensions'];
+    copy(this, object, names);
+    return object;
+};
+
+function setValue(object, name, value) {
+    if (typeof value !== 'undefined') {
+        object[name] = value;
+    }
+}
+
+function copy(source, target, names) {
+    for (var i = 0; i < names.length; i++) {
+        setValue(target, names[i], source[names[i]]);
+    }
+}
+
+exports.BinaryFeed = BinaryFeed;
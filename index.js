@@ -1,105 +1,195 @@
+var stream = require('stream');
+var util = require('util');
 var native = require('./build/Release/parser');
+var binary = require('./binary');
 
-function parseDate(article) {
-    if (typeof article.date !== 'undefined') {
-        article.date = new Date(Date.parse(article.date));
-    }
-}
+// Adds defaults for non-specified options.
+// Throws on invalid concurrency.
 
-// Finds "best" link for an Atom feed article.
-
-function atomLink(article) {
-    var link;
-    var links = article.links;
-    var best = false;
-    if (links.length > 0) {
-        link = links[0];
-    }
-    for (var i = 0; i < links.length; i++) {
-        var l = links[i];
-        if (l.rel === 'alternate') {
-            if (l.type === 'text/html') {
-                link = l;
-                best = true;
-            } else if (!best) {
-                link = l;
-            }
-        }
+function normalizeOptions(options) {
+    if (typeof options === 'undefined') {
+        options = {};
     }
-    if (link) {
-        if (link.href) {
-            article.link = link.href;
-        } else {
-            article.link = link.text;
-        }
+    if (typeof options.content === 'undefined') {
+        options.content = true;
     }
+    if (typeof options.extensions === 'undefined') {
+        options.extensions = false;
+    }
+    if (typeof options.concurrency === 'undefined') {
+        options.concurrency = 0;
+    }
+    var concurrency = options.concurrency;
+    if (typeof concurrency !== 'number' || Math.floor(concurrency) !== concurrency ||
+        concurrency < 0 || concurrency > 0xFFFFFFFF) {
+        throw new TypeError('The concurrency option must be a non-negative integer');
+    }
+    return options;
 }
 
-// Postprocess a single Atom feed article.
+// parse(xml, [options], [cb]).
 
-function postProcAtomArticle(article) {
-    parseDate(article);
-    atomLink(article);
-}
+exports.parse = function(xml, options, cb) {
+    // Options not given but callback is.
+    if (typeof options === 'function') {
+        cb = options;
+        options = {};
+    }
+    options = normalizeOptions(options);
+    if (typeof cb === 'function') {
+        // Parses on the libuv thread pool. Only building
+        // the result objects happens on the main thread.
+        native.parseAsync(xml, options, cb);
+    } else {
+        return native.parse(xml, options);
+    }
+};
 
-// Postprocess a single RSS 2 feed article.
+// parseAsync(xml, [options]) returns a Promise.
 
-function postProcRss2Article(article) {
-    parseDate(article);
-}
+exports.parseAsync = function(xml, options) {
+    options = normalizeOptions(options);
+    return new Promise(function(resolve, reject) {
+        native.parseAsync(xml, options, function(err, result) {
+            if (err) {
+                reject(err);
+            } else {
+                resolve(result);
+            }
+        });
+    });
+};
 
-// Postprocess the whole Atom feed.
+// parseMany(xmls, [options], [cb]).
 
-function postProcAtom(feed) {
-    feed.items.forEach(postProcAtomArticle);
-}
+exports.parseMany = function(xmls, options, cb) {
+    // Options not given but callback is.
+    if (typeof options === 'function') {
+        cb = options;
+        options = {};
+    }
+    options = normalizeOptions(options);
+    if (typeof cb === 'function') {
+        native.parseMany(xmls, options, cb);
+    } else {
+        return native.parseMany(xmls, options);
+    }
+};
 
-// Postprocess the whole RSS 2 feed.
+// Reusable parser. Keeps the input buffer and
+// the document memory between the calls.
 
-function postProcRss2(feed) {
-    feed.items.forEach(postProcRss2Article);
+function Parser(options) {
+    this.parser = new native.Parser(normalizeOptions(options));
 }
 
-function parseAndPostProc(xml, options) {
-    var result = native.parse(xml, options.content, options.extensions);
-    if (result.type === 'atom') {
-        postProcAtom(result);
+// parse(xml, [cb]).
+
+Parser.prototype.parse = function(xml, cb) {
+    if (typeof cb === 'function') {
+        this.parser.parseAsync(xml, cb);
     } else {
-        postProcRss2(result);
+        return this.parser.parse(xml);
     }
-    return result;
+};
+
+exports.Parser = Parser;
+
+// Incremental parser. Chunks are parsed as they
+// arrive and end() returns the whole feed in the
+// same form as parse().
+
+function IncrementalParser(options) {
+    this.parser = new native.StreamParser(normalizeOptions(options));
+    this.items = [];
 }
 
-// parse(xml, [options], [cb]).
+// write(chunk).
 
-exports.parse = function(xml, options, cb) {
-    // Options not given but callback is.
-    if (typeof options === 'function') {
-        cb = options;
-        options = {};
+IncrementalParser.prototype.write = function(chunk) {
+    var items = this.parser.write(chunk);
+    for (var i = 0; i < items.length; i++) {
+        this.items.push(items[i]);
     }
-    // Options not given, callback neither.
-    if (typeof options === 'undefined') {
-        options = {};
+};
+
+// end([chunk]) returns the feed.
+
+IncrementalParser.prototype.end = function(chunk) {
+    if (typeof chunk !== 'undefined') {
+        this.write(chunk);
     }
-    // Options given, add defaults for
-    // non-specified options.
-    if (typeof options.content === 'undefined') {
-        options.content = true;
+    this.parser.end();
+    var feed = this.parser.header();
+    feed.items = this.items;
+    return feed;
+};
+
+// createIncrementalParser([options]).
+
+exports.createIncrementalParser = function(options) {
+    return new IncrementalParser(options);
+};
+
+// Streaming parser. The feed is written in chunks
+// and the items are read one at a time. Memory use is
+// bounded by the largest single item. Emits the 'feed'
+// event with the feed properties (without items)
+// before the first item.
+
+function FeedStream(options) {
+    stream.Transform.call(this, { readableObjectMode: true });
+    this.parser = new native.StreamParser(normalizeOptions(options));
+    this.feed = undefined;
+}
+
+util.inherits(FeedStream, stream.Transform);
+
+FeedStream.prototype._transform = function(chunk, encoding, cb) {
+    var items;
+    try {
+        items = this.parser.write(chunk);
+    } catch (err) {
+        return cb(err);
     }
-    if (typeof options.extensions === 'undefined') {
-        options.extensions = false;
+    this._pushItems(items);
+    cb();
+};
+
+FeedStream.prototype._flush = function(cb) {
+    try {
+        this.parser.end();
+    } catch (err) {
+        return cb(err);
     }
-    var result;
-    if (typeof cb === 'function') {
-        try {
-            result = parseAndPostProc(xml, options);
-            cb(null, result);
-        } catch (err) {
-            cb(err);
+    this._emitFeed();
+    cb();
+};
+
+FeedStream.prototype._emitFeed = function() {
+    if (typeof this.feed === 'undefined') {
+        this.feed = this.parser.header();
+        if (typeof this.feed !== 'undefined') {
+            delete this.feed.items;
+            this.emit('feed', this.feed);
         }
-    } else {
-        result = parseAndPostProc(xml, options);
-        return result;
     }
 };
+
+FeedStream.prototype._pushItems = function(items) {
+    this._emitFeed();
+    for (var i = 0; i < items.length; i++) {
+        this.push(items[i]);
+    }
+};
+
+// createStream([options]).
+
+exports.createStream = function(options) {
+    return new FeedStream(options);
+};
+
+// Reader of the result parsed with the
+// binary option.
+
+exports.BinaryFeed = binary.BinaryFeed;
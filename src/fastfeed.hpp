@@ -0,0 +1,3150 @@
+#ifndef FASTFEED_HPP_INCLUDED
+#define FASTFEED_HPP_INCLUDED
+
+// Feed parsing core. Parses RSS and Atom feeds into
+// plain structs. Does not use V8 or libuv, so it is
+// used by the Node addon, the fastfeed command line
+// tool and the microbenchmark alike. Header-only
+// like RapidXML.
+
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <zlib.h>
+#include "rapidxml.hpp"
+
+namespace fastfeed {
+
+using namespace rapidxml;
+
+static char const *const EMPTY_C_STRING = "";
+
+// Error of a parse that runs out of memory.
+static char const *const OUT_OF_MEMORY = "Error: out of memory";
+
+// String value with its length. Points into the
+// parsed XML buffer and is nul-terminated there.
+// Missing values have 0 data.
+
+struct Text {
+    Text() : data(0), length(0) {}
+    Text(char const *data, size_t length) : data(data), length(length) {}
+
+    bool missing() const {
+        return data == 0;
+    }
+
+    // Compares against the string literal.
+    template<size_t N>
+    bool equals(const char (&value)[N]) const {
+        return data && length == N - 1 && memcmp(data, value, N - 1) == 0;
+    }
+
+    char const *data;
+    size_t length;
+};
+
+// Intermediate representation of the extracted feed.
+// It does not use V8 and can be filled on a worker
+// thread. String values point into the parsed XML
+// buffer.
+
+struct FeedExtension {
+    Text name;
+    Text value;
+    std::vector<std::pair<Text, Text> > attributes;
+};
+
+// 4.2.7. The "atom:link" Element
+
+struct Link {
+    Text rel;
+    Text href;
+    Text type;
+    Text hreflang;
+    Text title;
+    Text length;
+    Text text;
+};
+
+struct Enclosure {
+    Enclosure() : present(false), hasLength(false), length(0) {}
+    bool present;
+    bool hasLength;
+    long length;
+    Text type;
+    Text url;
+};
+
+struct Author {
+    Text name;
+    Text uri;
+    Text email;
+};
+
+struct Item {
+    Item() : dateParsed(false), time(0) {}
+    Text id;
+    Text title;
+    Text link;
+    Text date;
+    // Date as milliseconds since the epoch
+    // when it was parsed natively.
+    bool dateParsed;
+    double time;
+    Text description;
+    Text summary;
+    Text content;
+    Author author;
+    Enclosure enclosure;
+    std::vector<Text> categories;
+    std::vector<Link> links;
+    std::vector<FeedExtension> extensions;
+};
+
+// Measurements of a parse with the stats option.
+// Times are in nanoseconds.
+
+struct ParseStats {
+    ParseStats() : inputBytes(0), parseNs(0), extractNs(0), buildNs(0), nodes(0), poolBytes(0),
+        coalesced(0), items(0), extensions(0) {}
+
+    // Size of the input before decompression.
+    size_t inputBytes;
+    // Decompression and XML parsing.
+    uint64_t parseNs;
+    // Extraction of the values from the DOM.
+    uint64_t extractNs;
+    // Building of the result objects. Set
+    // by the caller of the parser.
+    uint64_t buildNs;
+    // Elements, text and CDATA nodes.
+    size_t nodes;
+    // Bytes used from the document memory pool.
+    size_t poolBytes;
+    // Text and CDATA nodes joined into
+    // the preceding node.
+    size_t coalesced;
+    size_t items;
+    // Feed and item extensions.
+    size_t extensions;
+};
+
+struct Feed {
+    Feed() : atom(false) {}
+
+    // Resets the feed for reuse. Keeps
+    // the capacity of the items.
+    void clear() {
+        atom = false;
+        title = Text();
+        id = Text();
+        link = Text();
+        description = Text();
+        author = Author();
+        extensions.clear();
+        items.clear();
+        warnings.clear();
+        stats = ParseStats();
+    }
+
+    bool atom;
+    Text title;
+    Text id;
+    Text link;
+    Text description;
+    Author author;
+    std::vector<FeedExtension> extensions;
+    std::vector<Item> items;
+    // Repairs made in the lenient mode.
+    std::vector<std::string> warnings;
+    // Filled with the stats option.
+    ParseStats stats;
+private:
+    Feed(const Feed&);
+    Feed &operator=(const Feed&);
+};
+
+// Item fields that can be requested
+// with the fields option.
+
+enum Field {
+    FIELD_ID = 1 << 0,
+    FIELD_TITLE = 1 << 1,
+    FIELD_LINK = 1 << 2,
+    FIELD_LINKS = 1 << 3,
+    FIELD_DATE = 1 << 4,
+    FIELD_AUTHOR = 1 << 5,
+    FIELD_AUTHOR_URI = 1 << 6,
+    FIELD_AUTHOR_EMAIL = 1 << 7,
+    FIELD_DESCRIPTION = 1 << 8,
+    FIELD_SUMMARY = 1 << 9,
+    FIELD_CONTENT = 1 << 10,
+    FIELD_CATEGORIES = 1 << 11,
+    FIELD_ENCLOSURE = 1 << 12,
+    FIELD_EXTENSIONS = 1 << 13,
+    FIELD_ALL = (1 << 14) - 1
+};
+
+struct FieldName {
+    const char *name;
+    unsigned int field;
+};
+
+static const FieldName FIELD_NAMES[] = {
+    { "id", FIELD_ID },
+    { "title", FIELD_TITLE },
+    { "link", FIELD_LINK },
+    { "links", FIELD_LINKS },
+    { "date", FIELD_DATE },
+    { "author", FIELD_AUTHOR },
+    { "author_uri", FIELD_AUTHOR_URI },
+    { "author_email", FIELD_AUTHOR_EMAIL },
+    { "description", FIELD_DESCRIPTION },
+    { "summary", FIELD_SUMMARY },
+    { "content", FIELD_CONTENT },
+    { "categories", FIELD_CATEGORIES },
+    { "enclosure", FIELD_ENCLOSURE },
+    { "extensions", FIELD_EXTENSIONS }
+};
+
+// Finds the field by its name.
+// Returns 0 for an unknown name.
+
+inline unsigned int findField(const char *name) {
+    for (size_t i = 0; i < sizeof(FIELD_NAMES) / sizeof(FieldName); i++) {
+        if (strcmp(FIELD_NAMES[i].name, name) == 0) {
+            return FIELD_NAMES[i].field;
+        }
+    }
+    return 0;
+}
+
+// Character encodings of the input. Inputs in
+// other encodings are parsed as UTF-8.
+
+enum Charset {
+    CHARSET_AUTO,
+    CHARSET_UTF8,
+    CHARSET_WINDOWS_1252,
+    CHARSET_UTF16,
+    CHARSET_UTF16LE,
+    CHARSET_UTF16BE,
+    CHARSET_UNKNOWN
+};
+
+struct CharsetName {
+    const char *name;
+    Charset charset;
+};
+
+// ISO-8859-1 is decoded as windows-1252
+// like browsers do.
+
+static const CharsetName CHARSET_NAMES[] = {
+    { "utf-8", CHARSET_UTF8 },
+    { "utf8", CHARSET_UTF8 },
+    { "us-ascii", CHARSET_UTF8 },
+    { "ascii", CHARSET_UTF8 },
+    { "iso-8859-1", CHARSET_WINDOWS_1252 },
+    { "iso8859-1", CHARSET_WINDOWS_1252 },
+    { "iso_8859-1", CHARSET_WINDOWS_1252 },
+    { "latin1", CHARSET_WINDOWS_1252 },
+    { "l1", CHARSET_WINDOWS_1252 },
+    { "windows-1252", CHARSET_WINDOWS_1252 },
+    { "cp1252", CHARSET_WINDOWS_1252 },
+    { "x-cp1252", CHARSET_WINDOWS_1252 },
+    { "utf-16", CHARSET_UTF16 },
+    { "utf-16le", CHARSET_UTF16LE },
+    { "utf-16be", CHARSET_UTF16BE }
+};
+
+// Finds the charset by its case-insensitive name.
+
+inline Charset findCharset(const char *name, size_t length) {
+    for (size_t i = 0; i < sizeof(CHARSET_NAMES) / sizeof(CharsetName); i++) {
+        if (strlen(CHARSET_NAMES[i].name) == length && strncasecmp(CHARSET_NAMES[i].name, name, length) == 0) {
+            return CHARSET_NAMES[i].charset;
+        }
+    }
+    return CHARSET_UNKNOWN;
+}
+
+// Compression of the input. Gzip and zlib
+// data is detected when not given.
+
+enum Compression {
+    COMPRESSION_AUTO,
+    COMPRESSION_NONE,
+    // Gzip or zlib.
+    COMPRESSION_GZIP,
+    // Zlib or raw deflate like the HTTP
+    // deflate encoding in practice.
+    COMPRESSION_DEFLATE,
+    COMPRESSION_DEFLATE_RAW
+};
+
+// Options for parsing and building the
+// result. Read once per call.
+
+struct ParseOptions {
+    ParseOptions() : extractContent(true), extractExtensions(false), stableShape(false),
+        timestamps(false), rawDates(false), atomLinks(true), fields(FIELD_ALL), externalThreshold(0),
+        lazy(false), charset(CHARSET_AUTO), compression(COMPRESSION_AUTO), lenient(false),
+        htmlEntities(false), stats(false), binary(false) {}
+
+    // Mask of the item fields to extract. Combines
+    // the requested fields with the other options.
+    unsigned int itemFields() const {
+        unsigned int mask = fields;
+        if (!extractContent) {
+            mask &= ~(FIELD_DESCRIPTION | FIELD_SUMMARY | FIELD_CONTENT);
+        }
+        if (!extractExtensions) {
+            mask &= ~FIELD_EXTENSIONS;
+        }
+        if (!atomLinks) {
+            mask &= ~FIELD_LINKS;
+        }
+        return mask;
+    }
+
+    bool extractContent;
+    bool extractExtensions;
+    bool stableShape;
+    // Dates as numbers instead of Date objects.
+    bool timestamps;
+    // Adds the original date strings.
+    bool rawDates;
+    // Adds the array of all Atom item links.
+    bool atomLinks;
+    // Requested item fields.
+    unsigned int fields;
+    // Minimum length of content, description and
+    // summary values returned as external strings.
+    // 0 turns external strings off.
+    size_t externalThreshold;
+    // Builds content values and item extensions
+    // on the first access.
+    bool lazy;
+    // Encoding of Buffer inputs given by the caller.
+    Charset charset;
+    // Compression of Buffer inputs.
+    Compression compression;
+    // Repairs malformed input instead of failing.
+    bool lenient;
+    // Translates HTML named character references
+    // like &nbsp; outside of CDATA sections.
+    bool htmlEntities;
+    // Measures the parse.
+    bool stats;
+    // Returns the feed as one ArrayBuffer.
+    bool binary;
+};
+
+// Monotonic clock for the stats.
+
+inline uint64_t monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Number of text nodes joined by readTextNode
+// on the current thread. Read for the stats.
+
+inline size_t &coalescedCount() {
+    static thread_local size_t count = 0;
+    return count;
+}
+
+// Helper to read text node value.
+// Consecutive text and CDATA children are joined
+// in-situ: the values are moved in document order
+// right after the first value, so no buffer is
+// allocated. The joined children are removed.
+
+inline Text readTextNode(xml_node<char> *node) {
+    xml_node<char> *textNode = node->first_node();
+    if (!textNode) {
+        return Text(EMPTY_C_STRING, 0);
+    }
+    if (textNode->next_sibling()) {
+        char *value = textNode->value();
+        char *target = value + textNode->value_size();
+        xml_node<char> *sibling = textNode->next_sibling();
+        while (sibling) {
+            xml_node<char> *next = sibling->next_sibling();
+            memmove(target, sibling->value(), sibling->value_size());
+            target += sibling->value_size();
+            node->remove_node(sibling);
+            coalescedCount()++;
+            sibling = next;
+        }
+        *target = '\0';
+        textNode->value(value, target - value);
+    }
+    return Text(textNode->value(), textNode->value_size());
+}
+
+// Checks whether the node has only
+// text, CDATA or comment children.
+
+inline bool textOnly(xml_node<char> *node) {
+    xml_node<char> *child = node->first_node();
+    while (child) {
+        if (child->type() != node_data &&
+            child->type() != node_cdata &&
+            child->type() != node_comment) {
+            return false;
+        }
+        child = child->next_sibling();
+    }
+    return true;
+}
+
+// Checks whether the given node is an
+// extension node.
+
+inline bool isExtension(xml_node<char> *node) {
+    // Check that name contains
+    // the namespace separator.
+    return memchr(node->name(), ':', node->name_size()) && textOnly(node);
+}
+
+// Known element and attribute names. Children
+// and attributes are walked once and dispatched
+// by their name.
+
+enum NodeName {
+    NAME_OTHER,
+    NAME_ID,
+    NAME_REL,
+    NAME_URI,
+    NAME_URL,
+    NAME_GUID,
+    NAME_HREF,
+    NAME_ITEM,
+    NAME_LINK,
+    NAME_NAME,
+    NAME_TYPE,
+    NAME_EMAIL,
+    NAME_ENTRY,
+    NAME_TITLE,
+    NAME_AUTHOR,
+    NAME_LENGTH,
+    NAME_CONTENT,
+    NAME_DC_DATE,
+    NAME_PUB_DATE,
+    NAME_SUMMARY,
+    NAME_UPDATED,
+    NAME_CATEGORY,
+    NAME_HREFLANG,
+    NAME_ENCLOSURE,
+    NAME_PUBLISHED,
+    NAME_DESCRIPTION,
+    NAME_CONTENT_ENCODED
+};
+
+// Compares the name against the candidate
+// of the same length.
+
+inline NodeName matchName(const char *name, const char *candidate, size_t length, NodeName value) {
+    return memcmp(name, candidate, length) == 0 ? value : NAME_OTHER;
+}
+
+// Finds the known name. The length and the first
+// character select at most one candidate.
+
+inline NodeName findName(const char *name, size_t length) {
+    switch (length) {
+        case 2:
+            return matchName(name, "id", 2, NAME_ID);
+        case 3:
+            switch (name[0]) {
+                case 'r': return matchName(name, "rel", 3, NAME_REL);
+                case 'u': return name[2] == 'i' ? matchName(name, "uri", 3, NAME_URI) :
+                    matchName(name, "url", 3, NAME_URL);
+            }
+            break;
+        case 4:
+            switch (name[0]) {
+                case 'g': return matchName(name, "guid", 4, NAME_GUID);
+                case 'h': return matchName(name, "href", 4, NAME_HREF);
+                case 'i': return matchName(name, "item", 4, NAME_ITEM);
+                case 'l': return matchName(name, "link", 4, NAME_LINK);
+                case 'n': return matchName(name, "name", 4, NAME_NAME);
+                case 't': return matchName(name, "type", 4, NAME_TYPE);
+            }
+            break;
+        case 5:
+            switch (name[0]) {
+                case 'e': return name[1] == 'm' ? matchName(name, "email", 5, NAME_EMAIL) :
+                    matchName(name, "entry", 5, NAME_ENTRY);
+                case 't': return matchName(name, "title", 5, NAME_TITLE);
+            }
+            break;
+        case 6:
+            switch (name[0]) {
+                case 'a': return matchName(name, "author", 6, NAME_AUTHOR);
+                case 'l': return matchName(name, "length", 6, NAME_LENGTH);
+            }
+            break;
+        case 7:
+            switch (name[0]) {
+                case 'c': return matchName(name, "content", 7, NAME_CONTENT);
+                case 'd': return matchName(name, "dc:date", 7, NAME_DC_DATE);
+                case 'p': return matchName(name, "pubDate", 7, NAME_PUB_DATE);
+                case 's': return matchName(name, "summary", 7, NAME_SUMMARY);
+                case 'u': return matchName(name, "updated", 7, NAME_UPDATED);
+            }
+            break;
+        case 8:
+            switch (name[0]) {
+                case 'c': return matchName(name, "category", 8, NAME_CATEGORY);
+                case 'h': return matchName(name, "hreflang", 8, NAME_HREFLANG);
+            }
+            break;
+        case 9:
+            switch (name[0]) {
+                case 'e': return matchName(name, "enclosure", 9, NAME_ENCLOSURE);
+                case 'p': return matchName(name, "published", 9, NAME_PUBLISHED);
+            }
+            break;
+        case 11:
+            return matchName(name, "description", 11, NAME_DESCRIPTION);
+        case 15:
+            return matchName(name, "content:encoded", 15, NAME_CONTENT_ENCODED);
+    }
+    return NAME_OTHER;
+}
+
+// Finds the known name of the element or attribute.
+
+template<class Node>
+NodeName findName(const Node *node) {
+    return findName(node->name(), node->name_size());
+}
+
+// Reads the text of the element unless the
+// value was already set by an earlier element
+// with the same name.
+
+inline void readFirst(Text &value, xml_node<char> *node) {
+    if (value.missing()) {
+        value = readTextNode(node);
+    }
+}
+
+// Same as readFirst but for an attribute value.
+
+inline void readFirst(Text &value, xml_attribute<char> *attribute) {
+    if (value.missing()) {
+        value = Text(attribute->value(), attribute->value_size());
+    }
+}
+
+// Extracts the extension from the given node
+// when it is one. Assumes that extensions use
+// namespaces.
+
+inline void readExtension(xml_node<char> *extensionNode, std::vector<FeedExtension> &extensions) {
+    if (!isExtension(extensionNode)) {
+        return;
+    }
+    extensions.push_back(FeedExtension());
+    FeedExtension &extension = extensions.back();
+    extension.name = Text(extensionNode->name(), extensionNode->name_size());
+    extension.value = readTextNode(extensionNode);
+    xml_attribute<char> *attributeNode = extensionNode->first_attribute();
+    while (attributeNode) {
+        extension.attributes.push_back(std::make_pair(
+            Text(attributeNode->name(), attributeNode->name_size()),
+            Text(attributeNode->value(), attributeNode->value_size())));
+        attributeNode = attributeNode->next_attribute();
+    }
+}
+
+// Helper to parse string into an integer.
+// From: https://stackoverflow.com/questions/14176123/correct-usage-of-strtol
+// Returns true when conversion was successful.
+
+inline bool parseLong(const char *str, long *val) {
+    char *temp;
+    bool rc = true;
+    errno = 0;
+    *val = strtol(str, &temp, 0);
+    if (temp == str || *temp != '\0' ||
+        ((*val == LONG_MIN || *val == LONG_MAX) && errno == ERANGE)) {
+            rc = false;
+        }
+    return rc;
+}
+
+// Extracts the enclosure from the given element.
+
+inline void readEnclosure(xml_node<char> *enclosureNode, Enclosure &enclosure) {
+    enclosure.present = true;
+    Text length;
+    xml_attribute<char> *attribute = enclosureNode->first_attribute();
+    while (attribute) {
+        switch (findName(attribute)) {
+            case NAME_LENGTH: readFirst(length, attribute); break;
+            case NAME_TYPE: readFirst(enclosure.type, attribute); break;
+            case NAME_URL: readFirst(enclosure.url, attribute); break;
+            default: break;
+        }
+        attribute = attribute->next_attribute();
+    }
+    if (!length.missing()) {
+        enclosure.hasLength = parseLong(length.data, &enclosure.length);
+    }
+}
+
+// Helper to find the line number of error.
+
+inline std::pair<int, int> findErrorLine(const char* xml, const char* where) {
+    int i = 0;
+    int ln = 1;
+    char ch = 0;
+    int col = 1;
+    while (true) {
+        if (xml + i == where) {
+            break;
+        }
+        ch = xml[i];
+        if (ch == '\n') {
+            ln++;
+            col = 0;
+        } else {
+            col++;
+        }
+        i++;
+    }
+    return std::pair<int, int>(ln, col);
+}
+
+// Days since 1970-01-01 for the given date
+// in the proleptic Gregorian calendar.
+// From: http://howardhinnant.github.io/date_algorithms.html
+
+inline long daysFromCivil(long y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned) (y - era * 400);
+    unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (long) doe - 719468;
+}
+
+// Helper to skip whitespace.
+
+inline char const *skipSpace(char const *str) {
+    while (*str == ' ' || *str == '\t' || *str == '\r' || *str == '\n') {
+        str++;
+    }
+    return str;
+}
+
+// Helper to read an unsigned decimal number
+// of at most maxDigits digits. Returns the
+// number of digits read.
+
+inline int readNumber(char const *&str, int maxDigits, int *value) {
+    int digits = 0;
+    *value = 0;
+    while (digits < maxDigits && *str >= '0' && *str <= '9') {
+        *value = *value * 10 + (*str - '0');
+        str++;
+        digits++;
+    }
+    return digits;
+}
+
+// Helper to read a word of ASCII letters into
+// the lowercase buffer. Returns the word length.
+// Longer words are read but truncated.
+
+inline size_t readWord(char const *&str, char *word, size_t size) {
+    size_t length = 0;
+    while ((*str >= 'a' && *str <= 'z') || (*str >= 'A' && *str <= 'Z')) {
+        if (length + 1 < size) {
+            word[length] = *str | 0x20;
+        }
+        length++;
+        str++;
+    }
+    word[length + 1 < size ? length : size - 1] = '\0';
+    return length;
+}
+
+// Finds the month (1-12) from the lowercase
+// English month name or its prefix of at least
+// three letters. Returns 0 when not a month.
+
+inline int findMonth(const char *word) {
+    static const char *MONTHS[] = {
+        "january", "february", "march", "april", "may", "june",
+        "july", "august", "september", "october", "november", "december"
+    };
+    size_t length = strlen(word);
+    if (length < 3) {
+        return 0;
+    }
+    for (int i = 0; i < 12; i++) {
+        if (strncmp(MONTHS[i], word, length) == 0) {
+            return i + 1;
+        }
+    }
+    // Common non-English abbreviation.
+    if (strcmp(word, "sept") == 0) {
+        return 9;
+    }
+    return 0;
+}
+
+// Timezone abbreviations commonly found
+// in feeds. Offsets are in minutes. IST
+// is India Standard Time.
+
+struct ZoneAbbreviation {
+    const char *name;
+    int offset;
+};
+
+static const ZoneAbbreviation ZONES[] = {
+    { "gmt", 0 }, { "ut", 0 }, { "utc", 0 }, { "z", 0 },
+    { "est", -300 }, { "edt", -240 }, { "cst", -360 }, { "cdt", -300 },
+    { "mst", -420 }, { "mdt", -360 }, { "pst", -480 }, { "pdt", -420 },
+    { "akst", -540 }, { "akdt", -480 }, { "hst", -600 },
+    { "ast", -240 }, { "adt", -180 }, { "nst", -210 }, { "ndt", -150 },
+    { "wet", 0 }, { "west", 60 }, { "bst", 60 }, { "ist", 330 },
+    { "cet", 60 }, { "cest", 120 }, { "met", 60 }, { "mest", 120 },
+    { "eet", 120 }, { "eest", 180 }, { "msk", 180 },
+    { "sgt", 480 }, { "hkt", 480 }, { "awst", 480 },
+    { "jst", 540 }, { "kst", 540 },
+    { "acst", 570 }, { "acdt", 630 }, { "aest", 600 }, { "aedt", 660 },
+    { "nzst", 720 }, { "nzdt", 780 }
+};
+
+// Reads a numeric offset like +hhmm, +hh:mm or +hh.
+// Returns false when there is no valid offset.
+
+inline bool readOffset(char const *&str, int *offset) {
+    if (*str != '+' && *str != '-') {
+        return false;
+    }
+    int sign = *str == '-' ? -1 : 1;
+    char const *cur = str + 1;
+    int hours = 0;
+    int minutes = 0;
+    int digits = readNumber(cur, 4, &hours);
+    if (digits == 4) {
+        minutes = hours % 100;
+        hours = hours / 100;
+    } else if (digits == 3) {
+        // Like +530.
+        minutes = hours % 100;
+        hours = hours / 100;
+    } else if (digits == 1 || digits == 2) {
+        if (*cur == ':') {
+            cur++;
+            if (readNumber(cur, 2, &minutes) != 2) {
+                return false;
+            }
+        }
+    } else {
+        return false;
+    }
+    if (hours > 23 || minutes > 59) {
+        return false;
+    }
+    *offset = sign * (hours * 60 + minutes);
+    str = cur;
+    return true;
+}
+
+// Reads the timezone as a numeric offset or as an
+// abbreviation, optionally followed by a numeric
+// offset (like GMT+0200). Returns false when the
+// zone is missing or unknown.
+
+inline bool readZone(char const *&str, int *offset) {
+    str = skipSpace(str);
+    if (readOffset(str, offset)) {
+        return true;
+    }
+    char word[8];
+    char const *cur = str;
+    size_t length = readWord(cur, word, sizeof(word));
+    if (length == 0 || length >= sizeof(word)) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(ZONES) / sizeof(ZoneAbbreviation); i++) {
+        if (strcmp(ZONES[i].name, word) == 0) {
+            *offset = ZONES[i].offset;
+            int extra = 0;
+            if (readOffset(cur, &extra)) {
+                *offset += extra;
+            }
+            str = cur;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Reads time in the form HH:MM[:SS[.fff]].
+
+inline bool readTime(char const *&str, int *hour, int *minute, int *second, int *millis) {
+    if (readNumber(str, 2, hour) == 0 || *str != ':') {
+        return false;
+    }
+    str++;
+    if (readNumber(str, 2, minute) != 2) {
+        return false;
+    }
+    *second = 0;
+    *millis = 0;
+    if (*str == ':') {
+        str++;
+        if (readNumber(str, 2, second) != 2) {
+            return false;
+        }
+        if (*str == '.' || *str == ',') {
+            str++;
+            int digits = readNumber(str, 3, millis);
+            if (digits == 0) {
+                return false;
+            }
+            for (; digits < 3; digits++) {
+                *millis *= 10;
+            }
+            // Skips precision beyond milliseconds.
+            while (*str >= '0' && *str <= '9') {
+                str++;
+            }
+        }
+    }
+    return *hour <= 24 && *minute <= 59 && *second <= 60;
+}
+
+// Computes the timestamp from the date components.
+
+inline bool makeTime(int year, int month, int day, int hour, int minute, int second,
+    int millis, int offset, double *time) {
+    if (month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+    if (second == 60) {
+        // Leap second.
+        second = 59;
+    }
+    double days = daysFromCivil(year, month, day);
+    double seconds = days * 86400 + hour * 3600 + minute * 60 + second - offset * 60;
+    *time = seconds * 1000 + millis;
+    return true;
+}
+
+// Helper to check that only whitespace or
+// a comment like (PST) is left.
+
+inline bool atEnd(char const *str) {
+    str = skipSpace(str);
+    return *str == '\0' || *str == '(';
+}
+
+// Parses a RFC 3339/ISO 8601 date like 2003-12-13T18:30:02Z.
+// A date without time is taken as UTC. Date-time without
+// timezone is rejected.
+
+inline bool parseIsoDate(char const *str, double *time) {
+    int year, month, day;
+    int hour = 0, minute = 0, second = 0, millis = 0, offset = 0;
+    if (readNumber(str, 4, &year) != 4 || *str != '-') {
+        return false;
+    }
+    str++;
+    if (readNumber(str, 2, &month) != 2 || *str != '-') {
+        return false;
+    }
+    str++;
+    if (readNumber(str, 2, &day) != 2) {
+        return false;
+    }
+    if (!atEnd(str)) {
+        if (*str != 'T' && *str != 't' && *str != ' ') {
+            return false;
+        }
+        str++;
+        if (!readTime(str, &hour, &minute, &second, &millis)) {
+            return false;
+        }
+        if (!readZone(str, &offset) || !atEnd(str)) {
+            return false;
+        }
+    }
+    return makeTime(year, month, day, hour, minute, second, millis, offset, time);
+}
+
+// Parses a RFC 822/RFC 1123 date like "Sat, 07 Sep 2002 09:42:31 GMT".
+// Tolerates missing or full weekday names, full month names, month
+// before day, two-digit years, missing seconds and many timezone
+// abbreviations. Dates without time or timezone are rejected.
+
+inline bool parseRfc822Date(char const *str, double *time) {
+    char word[16];
+    int year = 0, month = 0, day = 0;
+    int hour = 0, minute = 0, second = 0, millis = 0, offset = 0;
+    // Optional weekday.
+    char const *cur = str;
+    if (readWord(cur, word, sizeof(word)) > 0) {
+        month = findMonth(word);
+        if (month == 0) {
+            // Weekday, skip it.
+            cur = skipSpace(cur);
+            if (*cur == ',' || *cur == '.') {
+                cur++;
+            }
+            cur = skipSpace(cur);
+            readWord(cur, word, sizeof(word));
+            month = findMonth(word);
+        }
+    }
+    if (month != 0) {
+        // Month before day: Jun 10, 2003.
+        cur = skipSpace(cur);
+        if (readNumber(cur, 2, &day) == 0) {
+            return false;
+        }
+        cur = skipSpace(cur);
+        if (*cur == ',') {
+            cur++;
+        }
+    } else {
+        // Day before month: 10 Jun 2003.
+        if (readNumber(cur, 2, &day) == 0) {
+            return false;
+        }
+        cur = skipSpace(cur);
+        if (*cur == '-') {
+            cur++;
+        }
+        readWord(cur, word, sizeof(word));
+        month = findMonth(word);
+        if (month == 0) {
+            return false;
+        }
+        if (*cur == '.') {
+            cur++;
+        }
+        if (*cur == '-') {
+            cur++;
+        }
+    }
+    cur = skipSpace(cur);
+    // Three-digit years are left to Date.parse.
+    int digits = readNumber(cur, 4, &year);
+    if (digits == 2) {
+        year += year < 50 ? 2000 : 1900;
+    } else if (digits != 4) {
+        return false;
+    }
+    cur = skipSpace(cur);
+    if (*cur == ',') {
+        cur = skipSpace(cur + 1);
+    }
+    if (!readTime(cur, &hour, &minute, &second, &millis)) {
+        return false;
+    }
+    if (!readZone(cur, &offset)) {
+        return false;
+    }
+    if (!atEnd(cur)) {
+        return false;
+    }
+    return makeTime(year, month, day, hour, minute, second, millis, offset, time);
+}
+
+// Parses the date in RFC 822 or RFC 3339 format into
+// milliseconds since the epoch. Returns false when the
+// date cannot be parsed unambiguously.
+
+inline bool parseDate(char const *str, double *time) {
+    str = skipSpace(str);
+    if (str[0] >= '0' && str[0] <= '9' && str[1] >= '0' && str[1] <= '9' &&
+        str[2] >= '0' && str[2] <= '9' && str[3] >= '0' && str[3] <= '9') {
+        return parseIsoDate(str, time);
+    }
+    return parseRfc822Date(str, time);
+}
+
+// Sets the item date and parses it.
+
+inline void setItemDate(Item &item, const Text &date) {
+    item.date = date;
+    item.dateParsed = parseDate(date.data, &item.time);
+}
+
+// Parses the Atom feed/item author node.
+
+inline void parseAtomAuthor(xml_node<char> *authorNode, Author &author, unsigned int fields) {
+    if (!(fields & (FIELD_AUTHOR | FIELD_AUTHOR_URI | FIELD_AUTHOR_EMAIL))) {
+        return;
+    }
+    Text name;
+    Text uri;
+    Text email;
+    xml_node<char> *child = authorNode->first_node();
+    while (child) {
+        if (child->type() == node_element) {
+            switch (findName(child)) {
+                case NAME_NAME: readFirst(name, child); break;
+                case NAME_URI: readFirst(uri, child); break;
+                case NAME_EMAIL: readFirst(email, child); break;
+                default: break;
+            }
+        }
+        child = child->next_sibling();
+    }
+    if (!name.missing()) {
+        // Name node is set. Takes uri
+        // and email nodes too.
+        if (fields & FIELD_AUTHOR) {
+            author.name = name;
+        }
+        if (fields & FIELD_AUTHOR_URI) {
+            author.uri = uri;
+        }
+        if (fields & FIELD_AUTHOR_EMAIL) {
+            author.email = email;
+        }
+    } else if (fields & FIELD_AUTHOR) {
+        // Whole author node is probably a text node.
+        author.name = readTextNode(authorNode);
+    }
+}
+
+// Reads the Atom link element attributes.
+
+inline void readAtomLink(xml_node<char> *linkNode, Link &link) {
+    xml_attribute<char> *attribute = linkNode->first_attribute();
+    while (attribute) {
+        switch (findName(attribute)) {
+            case NAME_REL: readFirst(link.rel, attribute); break;
+            case NAME_HREF: readFirst(link.href, attribute); break;
+            case NAME_TYPE: readFirst(link.type, attribute); break;
+            case NAME_HREFLANG: readFirst(link.hreflang, attribute); break;
+            case NAME_TITLE: readFirst(link.title, attribute); break;
+            case NAME_LENGTH: readFirst(link.length, attribute); break;
+            default: break;
+        }
+        attribute = attribute->next_attribute();
+    }
+    xml_node<char> *textNode = linkNode->first_node();
+    // This is not by spec but some feeds
+    // put URL/IRI into link's text node like:
+    // <link>http://example.com</link>
+    if (textNode) {
+        link.text = Text(textNode->value(), textNode->value_size());
+    }
+}
+
+// Selects the best link of the Atom entry.
+// Takes the first link unless there are alternate
+// links. The last alternate text/html link wins.
+// 4.2.7. The "atom:link" Element
+
+struct BestLink {
+    BestLink() : found(false), html(false) {}
+
+    void add(const Link &candidate) {
+        bool isAlternate = candidate.rel.equals("alternate");
+        bool isHtml = candidate.type.equals("text/html");
+        if (!found || (isAlternate && (isHtml || !html))) {
+            link = candidate;
+            found = true;
+            html = html || (isAlternate && isHtml);
+        }
+    }
+
+    Link link;
+    bool found;
+    bool html;
+};
+
+// Parses the Atom entry. Walks the
+// children once.
+
+inline void parseAtomItem(xml_node<char> *itemNode, Item &item, unsigned int fields) {
+    BestLink best;
+    xml_node<char> *authorNode = 0;
+    Text updated;
+    Text published;
+    xml_node<char> *child = itemNode->first_node();
+    while (child) {
+        if (child->type() != node_element) {
+            child = child->next_sibling();
+            continue;
+        }
+        switch (findName(child)) {
+            case NAME_ID:
+                if (fields & FIELD_ID) {
+                    readFirst(item.id, child);
+                }
+                break;
+            case NAME_LINK:
+                if (fields & (FIELD_LINK | FIELD_LINKS)) {
+                    Link link;
+                    readAtomLink(child, link);
+                    best.add(link);
+                    if (fields & FIELD_LINKS) {
+                        item.links.push_back(link);
+                    }
+                }
+                break;
+            case NAME_TITLE:
+                if (fields & FIELD_TITLE) {
+                    readFirst(item.title, child);
+                }
+                break;
+            case NAME_UPDATED:
+                if (fields & FIELD_DATE) {
+                    readFirst(updated, child);
+                }
+                break;
+            case NAME_PUBLISHED:
+                if (fields & FIELD_DATE) {
+                    readFirst(published, child);
+                }
+                break;
+            case NAME_AUTHOR:
+                if (!authorNode) {
+                    authorNode = child;
+                }
+                break;
+            case NAME_SUMMARY:
+                if (fields & FIELD_SUMMARY) {
+                    readFirst(item.summary, child);
+                }
+                break;
+            case NAME_CONTENT:
+                if (fields & FIELD_CONTENT) {
+                    readFirst(item.content, child);
+                }
+                break;
+            default:
+                break;
+        }
+        // Extracts extensions when configured to.
+        if (fields & FIELD_EXTENSIONS) {
+            readExtension(child, item.extensions);
+        }
+        child = child->next_sibling();
+    }
+    if (best.found && (fields & FIELD_LINK)) {
+        const Link &link = best.link;
+        item.link = link.href.length > 0 ? link.href : link.text;
+    }
+    // The updated property, falls back
+    // to the published property.
+    Text date = updated.missing() ? published : updated;
+    if (!date.missing()) {
+        setItemDate(item, date);
+    }
+    if (authorNode) {
+        parseAtomAuthor(authorNode, item.author, fields);
+    }
+}
+
+// Parses the Atom feed.
+
+inline void parseAtomFeed(xml_node<char> *feedNode, Feed &feed, const ParseOptions &options) {
+    feed.atom = true;
+    unsigned int fields = options.itemFields();
+    bool hasLink = false;
+    bool hasAuthor = false;
+    xml_node<char> *child = feedNode->first_node();
+    while (child) {
+        if (child->type() != node_element) {
+            child = child->next_sibling();
+            continue;
+        }
+        switch (findName(child)) {
+            case NAME_TITLE:
+                readFirst(feed.title, child);
+                break;
+            case NAME_ID:
+                readFirst(feed.id, child);
+                break;
+            case NAME_LINK:
+                // The link property is the href
+                // of the first link element.
+                if (!hasLink) {
+                    hasLink = true;
+                    Link link;
+                    readAtomLink(child, link);
+                    feed.link = link.href;
+                }
+                break;
+            case NAME_AUTHOR:
+                if (!hasAuthor) {
+                    hasAuthor = true;
+                    parseAtomAuthor(child, feed.author, FIELD_ALL);
+                }
+                break;
+            case NAME_ENTRY:
+                feed.items.push_back(Item());
+                parseAtomItem(child, feed.items.back(), fields);
+                break;
+            default:
+                break;
+        }
+        // Extracts extensions when configured to.
+        if (options.extractExtensions) {
+            readExtension(child, feed.extensions);
+        }
+        child = child->next_sibling();
+    }
+}
+
+// Parses the RSS item. Walks the
+// children once.
+
+inline void parseRssItem(xml_node<char> *itemNode, Item &item, unsigned int fields) {
+    Text dcDate;
+    Text pubDate;
+    xml_node<char> *child = itemNode->first_node();
+    while (child) {
+        if (child->type() != node_element) {
+            child = child->next_sibling();
+            continue;
+        }
+        switch (findName(child)) {
+            case NAME_CATEGORY:
+                if (fields & FIELD_CATEGORIES) {
+                    item.categories.push_back(readTextNode(child));
+                }
+                break;
+            case NAME_GUID:
+                if (fields & FIELD_ID) {
+                    readFirst(item.id, child);
+                }
+                break;
+            case NAME_LINK:
+                if (fields & FIELD_LINK) {
+                    readFirst(item.link, child);
+                }
+                break;
+            case NAME_DC_DATE:
+                if (fields & FIELD_DATE) {
+                    readFirst(dcDate, child);
+                }
+                break;
+            case NAME_PUB_DATE:
+                if (fields & FIELD_DATE) {
+                    readFirst(pubDate, child);
+                }
+                break;
+            case NAME_TITLE:
+                if (fields & FIELD_TITLE) {
+                    readFirst(item.title, child);
+                }
+                break;
+            case NAME_AUTHOR:
+                if (fields & FIELD_AUTHOR) {
+                    readFirst(item.author.name, child);
+                }
+                break;
+            case NAME_ENCLOSURE:
+                if ((fields & FIELD_ENCLOSURE) && !item.enclosure.present) {
+                    readEnclosure(child, item.enclosure);
+                }
+                break;
+            case NAME_DESCRIPTION:
+                if (fields & FIELD_DESCRIPTION) {
+                    readFirst(item.description, child);
+                }
+                break;
+            // <content:encoded> is a popular RSS extension.
+            // More info: https://developer.mozilla.org/en-US/docs/Web/RSS/Article/Why_RSS_Content_Module_is_Popular_-_Including_HTML_Contents
+            case NAME_CONTENT_ENCODED:
+                if (fields & FIELD_CONTENT) {
+                    readFirst(item.content, child);
+                }
+                break;
+            default:
+                break;
+        }
+        // Extracts extensions when configured to.
+        if (fields & FIELD_EXTENSIONS) {
+            readExtension(child, item.extensions);
+        }
+        child = child->next_sibling();
+    }
+    // The date from the Dublin Core extension
+    // or from the pubDate property.
+    Text date = dcDate.missing() ? pubDate : dcDate;
+    if (!date.missing()) {
+        setItemDate(item, date);
+    }
+}
+
+// Parses the RSS feed.
+// Returns false when the channel element is missing.
+
+inline bool parseRssFeed(xml_node<char> *rssNode, Feed &feed, const ParseOptions &options) {
+    xml_node<char> *channelNode = rssNode->first_node("channel");
+    if (!channelNode) {
+        return false;
+    }
+    unsigned int fields = options.itemFields();
+    xml_node<char> *child = channelNode->first_node();
+    while (child) {
+        if (child->type() != node_element) {
+            child = child->next_sibling();
+            continue;
+        }
+        switch (findName(child)) {
+            case NAME_TITLE:
+                readFirst(feed.title, child);
+                break;
+            case NAME_DESCRIPTION:
+                readFirst(feed.description, child);
+                break;
+            case NAME_LINK:
+                readFirst(feed.link, child);
+                break;
+            case NAME_AUTHOR:
+                readFirst(feed.author.name, child);
+                break;
+            case NAME_ITEM:
+                feed.items.push_back(Item());
+                parseRssItem(child, feed.items.back(), fields);
+                break;
+            default:
+                break;
+        }
+        // Extracts extensions when configured to.
+        if (options.extractExtensions) {
+            readExtension(child, feed.extensions);
+        }
+        child = child->next_sibling();
+    }
+    return true;
+}
+
+// Parses the XML in-situ. HTML named character
+// references are translated too with the
+// htmlEntities option.
+
+inline void parseDocument(xml_document<char> &doc, char *xml, const ParseOptions &options) {
+    if (options.htmlEntities) {
+        doc.parse<parse_html_entities>(xml);
+    } else {
+        doc.parse<0>(xml);
+    }
+}
+
+// Counts the nodes below the given node
+// without recursion.
+
+inline size_t countNodes(xml_node<char> *root) {
+    size_t count = 0;
+    xml_node<char> *node = root->first_node();
+    while (node) {
+        count++;
+        if (node->first_node()) {
+            node = node->first_node();
+            continue;
+        }
+        while (node != root && !node->next_sibling()) {
+            node = node->parent();
+        }
+        if (node == root) {
+            break;
+        }
+        node = node->next_sibling();
+    }
+    return count;
+}
+
+// Extracts the feed from the parsed document.
+
+inline bool extractFeed(xml_document<char> &doc, Feed &feed, const ParseOptions &options, std::string &error) {
+    // Tries to get either <rss> or <feed> node.
+    xml_node<> *rssNode = doc.first_node("rss");
+    if (rssNode) {
+        if (!parseRssFeed(rssNode, feed, options)) {
+            error = "Invalid RSS channel.";
+            return false;
+        }
+    } else {
+        xml_node<> *feedNode = doc.first_node("feed");
+        if (feedNode) {
+            parseAtomFeed(feedNode, feed, options);
+        } else {
+            error = "Invalid feed.";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Extracts the feed and fills the stats.
+
+inline bool extractFeedStats(xml_document<char> &doc, Feed &feed, const ParseOptions &options, std::string &error) {
+    ParseStats &stats = feed.stats;
+    stats.nodes = countNodes(&doc);
+    stats.poolBytes = doc.used_size();
+    coalescedCount() = 0;
+    uint64_t start = monotonicNs();
+    bool ok = extractFeed(doc, feed, options, error);
+    stats.extractNs += monotonicNs() - start;
+    stats.coalesced = coalescedCount();
+    stats.items = feed.items.size();
+    stats.extensions = feed.extensions.size();
+    for (size_t i = 0; i < feed.items.size(); i++) {
+        stats.extensions += feed.items[i].extensions.size();
+    }
+    return ok;
+}
+
+// Parses the given XML buffer in-situ and extracts
+// the feed. Does not use V8 and is safe to call on a
+// worker thread. Returns false and sets the error
+// message when parsing fails.
+
+inline bool parseFeed(xml_document<char> &doc, char *xml, Feed &feed, const ParseOptions &options, std::string &error) {
+    uint64_t start = options.stats ? monotonicNs() : 0;
+    try {
+        parseDocument(doc, xml, options);
+    } catch(rapidxml::parse_error &e) {
+        std::pair<int, int> loc = findErrorLine(xml, e.where<char>());
+        std::stringstream err;
+        err << "Error on line " << loc.first;
+        err << ", column " << loc.second;
+        err << ": " << e.what();
+        error = err.str();
+        return false;
+    }
+    if (options.stats) {
+        feed.stats.parseNs += monotonicNs() - start;
+        return extractFeedStats(doc, feed, options, error);
+    }
+    return extractFeed(doc, feed, options, error);
+}
+
+// Same as parseFeed(xml_document<char>, ...) but
+// uses a new document.
+
+inline bool parseFeed(char *xml, Feed &feed, const ParseOptions &options, std::string &error) {
+    xml_document<char> doc;
+    return parseFeed(doc, xml, feed, options, error);
+}
+
+// Cache of the RapidXML dynamic pool blocks kept
+// between parses. The blocks above the high-water
+// mark are freed. RapidXML allocator functions take
+// no context so the cache in use is set per thread
+// with CacheScope.
+
+class BlockCache {
+public:
+    BlockCache(size_t highWaterMark) : highWaterMark(highWaterMark), cached(0) {}
+
+    ~BlockCache() {
+        trim(0);
+    }
+
+    void *allocate(size_t size) {
+        for (size_t i = blocks.size(); i > 0; i--) {
+            char *block = blocks[i - 1];
+            if (blockSize(block) >= size) {
+                blocks.erase(blocks.begin() + (i - 1));
+                cached -= blockSize(block);
+                return block + HEADER_SIZE;
+            }
+        }
+        return newBlock(size);
+    }
+
+    void release(void *memory) {
+        char *block = static_cast<char*>(memory) - HEADER_SIZE;
+        blocks.push_back(block);
+        cached += blockSize(block);
+    }
+
+    // Frees the cached blocks above the limit.
+    void trim(size_t limit) {
+        while (cached > limit && !blocks.empty()) {
+            cached -= blockSize(blocks.back());
+            free(blocks.back());
+            blocks.pop_back();
+        }
+    }
+
+    void trim() {
+        trim(highWaterMark);
+    }
+
+    // Allocates the block with the size
+    // header. Used without the cache too.
+    static void *newBlock(size_t size) {
+        char *block = static_cast<char*>(malloc(size + HEADER_SIZE));
+        if (!block) {
+            throw std::bad_alloc();
+        }
+        *reinterpret_cast<size_t*>(block) = size;
+        return block + HEADER_SIZE;
+    }
+
+    static size_t blockSize(char *block) {
+        return *reinterpret_cast<size_t*>(block);
+    }
+
+    // Keeps the blocks aligned as returned by malloc.
+    static const size_t HEADER_SIZE = 16;
+
+private:
+    size_t highWaterMark;
+    size_t cached;
+    std::vector<char*> blocks;
+};
+
+// The cache in use on the current thread.
+
+inline BlockCache *&currentCache() {
+    static thread_local BlockCache *cache = 0;
+    return cache;
+}
+
+// RapidXML allocator function using the current cache.
+
+inline void *allocateBlock(size_t size) {
+    BlockCache *cache = currentCache();
+    if (cache) {
+        return cache->allocate(size);
+    }
+    return BlockCache::newBlock(size);
+}
+
+// RapidXML free function using the current cache.
+
+inline void releaseBlock(void *memory) {
+    BlockCache *cache = currentCache();
+    if (cache) {
+        cache->release(memory);
+    } else {
+        free(static_cast<char*>(memory) - BlockCache::HEADER_SIZE);
+    }
+}
+
+// Sets the current cache of the thread
+// for the lifetime of the scope.
+
+class CacheScope {
+public:
+    CacheScope(BlockCache *cache) {
+        currentCache() = cache;
+    }
+
+    ~CacheScope() {
+        currentCache() = 0;
+    }
+};
+
+// Finds the token in the buffer starting from
+// the given position. Returns the position of
+// the token or the end when not found.
+
+inline size_t findToken(const char *buffer, size_t start, size_t end, const char *token, size_t length) {
+    const char *pos = buffer + start;
+    const char *last = buffer + end;
+    while (pos + length <= last) {
+        pos = static_cast<const char*>(memchr(pos, token[0], last - pos - length + 1));
+        if (!pos) {
+            break;
+        }
+        if (memcmp(pos, token, length) == 0) {
+            return pos - buffer;
+        }
+        pos++;
+    }
+    return end;
+}
+
+// Rewrites malformed XML into well-formed XML for
+// the lenient mode. Escapes stray < and & characters,
+// quotes attribute values, closes unclosed elements,
+// drops unexpected end tags and closes a truncated
+// document without its incomplete item. Adds a
+// warning for each repair. Does not use V8.
+
+class XmlRepair {
+public:
+    XmlRepair(const char *input, size_t length, std::vector<std::string> &warnings)
+        : input(input), end(input + length), pos(input), warnings(warnings), line(1), counted(input) {}
+
+    void run(std::vector<char> &out) {
+        out.reserve(end - input + 64);
+        while (pos < end) {
+            const char *text = pos;
+            while (pos < end && *pos != '<' && *pos != '&') {
+                pos++;
+            }
+            out.insert(out.end(), text, pos);
+            if (pos == end) {
+                break;
+            }
+            if (*pos == '&') {
+                entity(out);
+            } else if (!markup(out)) {
+                break;
+            }
+        }
+        finish(out);
+    }
+
+private:
+    struct Element {
+        std::string name;
+        // Output position of the start tag.
+        size_t start;
+        bool item;
+    };
+
+    static const size_t MAX_WARNINGS = 100;
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    static bool isNameStart(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':' ||
+            static_cast<unsigned char>(c) >= 0x80;
+    }
+
+    static bool isNameChar(char c) {
+        return isNameStart(c) || (c >= '0' && c <= '9') || c == '-' || c == '.';
+    }
+
+    // Whether the element is an RSS item
+    // or an Atom entry, with any prefix.
+    static bool isItem(const std::string &name) {
+        size_t colon = name.rfind(':');
+        std::string local = colon == std::string::npos ? name : name.substr(colon + 1);
+        return local == "item" || local == "entry";
+    }
+
+    void warn(const char *at, const std::string &message) {
+        if (warnings.size() > MAX_WARNINGS) {
+            return;
+        }
+        if (warnings.size() == MAX_WARNINGS) {
+            warnings.push_back("Too many warnings");
+            return;
+        }
+        for (; counted < at; counted++) {
+            if (*counted == '\n') {
+                line++;
+            }
+        }
+        std::stringstream warning;
+        warning << "Line " << line << ": " << message;
+        warnings.push_back(warning.str());
+    }
+
+    bool startsWith(const char *token) const {
+        size_t length = strlen(token);
+        return static_cast<size_t>(end - pos) >= length && memcmp(pos, token, length) == 0;
+    }
+
+    // Finds the token after from. Returns 0
+    // when it is not found.
+    const char *find(const char *from, const char *token) const {
+        size_t length = strlen(token);
+        size_t found = findToken(input, from - input, end - input, token, length);
+        return found == static_cast<size_t>(end - input) ? 0 : input + found;
+    }
+
+    void append(std::vector<char> &out, const char *from, const char *to) {
+        out.insert(out.end(), from, to);
+    }
+
+    void append(std::vector<char> &out, const std::string &text) {
+        out.insert(out.end(), text.begin(), text.end());
+    }
+
+    // Copies a valid entity or character
+    // reference, escapes a bare &.
+    void entity(std::vector<char> &out) {
+        const char *p = pos + 1;
+        const char *start;
+        bool valid;
+        if (p < end && *p == '#') {
+            p++;
+            if (p < end && *p == 'x') {
+                p++;
+                start = p;
+                while (p < end && isxdigit(static_cast<unsigned char>(*p))) {
+                    p++;
+                }
+            } else {
+                start = p;
+                while (p < end && *p >= '0' && *p <= '9') {
+                    p++;
+                }
+            }
+            valid = p > start;
+        } else {
+            start = p;
+            while (p < end && isNameChar(*p)) {
+                p++;
+            }
+            valid = p > start && isNameStart(*start);
+        }
+        if (valid && p < end && *p == ';') {
+            append(out, pos, p + 1);
+            pos = p + 1;
+        } else {
+            warn(pos, "unescaped &");
+            append(out, "&amp;");
+            pos++;
+        }
+    }
+
+    // Copies the markup starting at <. Returns
+    // false when the document ends inside it.
+    bool markup(std::vector<char> &out) {
+        if (startsWith("<!--")) {
+            return section(out, pos + 4, "-->", "comment");
+        } else if (startsWith("<![CDATA[")) {
+            return section(out, pos + 9, "]]>", "CDATA section");
+        } else if (startsWith("<?")) {
+            const char *close = find(pos + 2, "?>");
+            if (!close) {
+                warn(pos, "unterminated processing instruction");
+                pos = end;
+                return false;
+            }
+            append(out, pos, close + 2);
+            pos = close + 2;
+            return true;
+        } else if (startsWith("<!")) {
+            return declaration(out);
+        } else if (startsWith("</")) {
+            return endTag(out);
+        } else if (pos + 1 < end && isNameStart(pos[1])) {
+            return startTag(out);
+        }
+        warn(pos, "unescaped <");
+        append(out, "&lt;");
+        pos++;
+        return true;
+    }
+
+    // Copies the comment or CDATA section.
+    // Closes an unterminated one.
+    bool section(std::vector<char> &out, const char *from, const char *close, const char *name) {
+        const char *found = find(from, close);
+        if (!found) {
+            warn(pos, std::string("unterminated ") + name);
+            append(out, pos, end);
+            append(out, close);
+            pos = end;
+            return true;
+        }
+        found += strlen(close);
+        append(out, pos, found);
+        pos = found;
+        return true;
+    }
+
+    // Copies the DOCTYPE declaration
+    // with its internal subset.
+    bool declaration(std::vector<char> &out) {
+        int brackets = 0;
+        for (const char *p = pos + 2; p < end; p++) {
+            if (*p == '[') {
+                brackets++;
+            } else if (*p == ']') {
+                brackets--;
+            } else if (*p == '>' && brackets <= 0) {
+                append(out, pos, p + 1);
+                pos = p + 1;
+                return true;
+            }
+        }
+        warn(pos, "unterminated declaration");
+        pos = end;
+        return false;
+    }
+
+    bool startTag(std::vector<char> &out) {
+        size_t start = out.size();
+        const char *p = pos + 1;
+        const char *nameStart = p;
+        while (p < end && isNameChar(*p)) {
+            p++;
+        }
+        std::string name(nameStart, p);
+        append(out, pos, p);
+        for (;;) {
+            while (p < end && isSpace(*p)) {
+                p++;
+            }
+            if (p == end) {
+                break;
+            }
+            if (*p == '>') {
+                out.push_back('>');
+                Element element = { name, start, isItem(name) };
+                stack.push_back(element);
+                pos = p + 1;
+                return true;
+            }
+            if (*p == '/' && p + 1 < end && p[1] == '>') {
+                append(out, "/>");
+                pos = p + 2;
+                return true;
+            }
+            if (isNameStart(*p)) {
+                if (!attribute(out, p)) {
+                    break;
+                }
+            } else {
+                warn(p, "unexpected character in <" + name + ">");
+                p++;
+            }
+        }
+        // The document ends inside the tag.
+        out.resize(start);
+        pos = end;
+        return false;
+    }
+
+    // Copies the attribute. Quotes an unquoted
+    // value and adds an empty missing value.
+    bool attribute(std::vector<char> &out, const char *&p) {
+        const char *nameStart = p;
+        while (p < end && isNameChar(*p)) {
+            p++;
+        }
+        out.push_back(' ');
+        append(out, nameStart, p);
+        while (p < end && isSpace(*p)) {
+            p++;
+        }
+        if (p == end) {
+            return false;
+        }
+        if (*p != '=') {
+            warn(p, "attribute " + std::string(nameStart, p - nameStart) + " without value");
+            append(out, "=\"\"");
+            return true;
+        }
+        p++;
+        while (p < end && isSpace(*p)) {
+            p++;
+        }
+        if (p == end) {
+            return false;
+        }
+        out.push_back('=');
+        if (*p == '"' || *p == '\'') {
+            const char *close = static_cast<const char*>(memchr(p + 1, *p, end - p - 1));
+            if (!close) {
+                return false;
+            }
+            append(out, p, close + 1);
+            p = close + 1;
+            return true;
+        }
+        warn(p, "unquoted attribute value");
+        out.push_back('"');
+        while (p < end && !isSpace(*p) && *p != '>' && !(*p == '/' && p + 1 < end && p[1] == '>')) {
+            if (*p == '"') {
+                append(out, "&quot;");
+            } else if (*p == '<') {
+                append(out, "&lt;");
+            } else {
+                out.push_back(*p);
+            }
+            p++;
+        }
+        out.push_back('"');
+        return p < end;
+    }
+
+    // Closes the matching open element and the
+    // unclosed elements inside it. Drops an end
+    // tag without the open element.
+    bool endTag(std::vector<char> &out) {
+        const char *p = pos + 2;
+        const char *nameStart = p;
+        while (p < end && isNameChar(*p)) {
+            p++;
+        }
+        std::string name(nameStart, p);
+        const char *close = static_cast<const char*>(memchr(p, '>', end - p));
+        if (!close) {
+            pos = end;
+            return false;
+        }
+        size_t k = stack.size();
+        while (k > 0 && stack[k - 1].name != name) {
+            k--;
+        }
+        if (k == 0) {
+            warn(pos, "unexpected end tag </" + name + ">");
+        } else {
+            while (stack.size() > k) {
+                warn(pos, "unclosed element <" + stack.back().name + ">");
+                closeElement(out);
+            }
+            closeElement(out);
+        }
+        pos = close + 1;
+        return true;
+    }
+
+    void closeElement(std::vector<char> &out) {
+        append(out, "</");
+        append(out, stack.back().name);
+        out.push_back('>');
+        stack.pop_back();
+    }
+
+    // Closes the open elements at the end of a
+    // truncated document. The incomplete item
+    // is dropped.
+    void finish(std::vector<char> &out) {
+        if (stack.empty()) {
+            return;
+        }
+        warn(end, "unexpected end of document");
+        for (size_t i = 0; i < stack.size(); i++) {
+            if (stack[i].item) {
+                warn(end, "incomplete <" + stack[i].name + "> dropped");
+                out.resize(stack[i].start);
+                stack.resize(i);
+                break;
+            }
+        }
+        while (!stack.empty()) {
+            closeElement(out);
+        }
+    }
+
+    const char *input;
+    const char *end;
+    const char *pos;
+    std::vector<std::string> &warnings;
+    std::vector<Element> stack;
+    int line;
+    const char *counted;
+};
+
+// Checks for the gzip header.
+
+inline bool isGzip(const char *data, size_t length) {
+    return length >= 2 && static_cast<unsigned char>(data[0]) == 0x1F && static_cast<unsigned char>(data[1]) == 0x8B;
+}
+
+// Checks for the zlib header. XML cannot
+// start with a valid zlib header.
+
+inline bool isZlib(const char *data, size_t length) {
+    if (length < 2) {
+        return false;
+    }
+    unsigned int cmf = static_cast<unsigned char>(data[0]);
+    unsigned int flg = static_cast<unsigned char>(data[1]);
+    return (cmf & 0x0F) == 8 && (cmf >> 4) <= 7 && ((cmf << 8) | flg) % 31 == 0;
+}
+
+// Finds the compression of the data from
+// its header and the compression option.
+// Returns one of none, gzip and raw deflate.
+
+inline Compression detectCompression(const char *data, size_t length, Compression option) {
+    switch (option) {
+    case COMPRESSION_NONE:
+    case COMPRESSION_GZIP:
+    case COMPRESSION_DEFLATE_RAW:
+        return option;
+    case COMPRESSION_DEFLATE:
+        return isZlib(data, length) ? COMPRESSION_GZIP : COMPRESSION_DEFLATE_RAW;
+    default:
+        return isGzip(data, length) || isZlib(data, length) ? COMPRESSION_GZIP : COMPRESSION_NONE;
+    }
+}
+
+// Inflates gzip, zlib or raw deflate data given
+// in pieces into the given space. Concatenated
+// gzip members are inflated one after another.
+// Does not use V8.
+
+class Inflater {
+public:
+    Inflater() : started(false), ended(false), pending(false), next(0), remaining(0) {}
+
+    ~Inflater() {
+        if (started) {
+            inflateEnd(&stream);
+        }
+    }
+
+    // Starts inflating in the given format:
+    // gzip (also accepts zlib) or raw deflate.
+    bool start(Compression compression, std::string &error) {
+        memset(&stream, 0, sizeof(stream));
+        int windowBits = compression == COMPRESSION_DEFLATE_RAW ? -15 : 15 + 32;
+        if (inflateInit2(&stream, windowBits) != Z_OK) {
+            error = "Error: cannot start decompression";
+            return false;
+        }
+        started = true;
+        return true;
+    }
+
+    // Sets the next piece of compressed data.
+    // The data must stay valid until it is used.
+    void feed(const char *data, size_t length) {
+        next = data;
+        remaining = length;
+    }
+
+    // Whether the given data has been used and
+    // all output from it has been read.
+    bool used() const {
+        return stream.avail_in == 0 && remaining == 0 && !pending;
+    }
+
+    // Whether the end of the compressed
+    // data has been reached.
+    bool finished() const {
+        return ended;
+    }
+
+    // Inflates into the space. Sets the number of
+    // bytes written. Stops when the space is full
+    // or the given data is used and its output
+    // has been read.
+    bool read(char *out, size_t space, size_t *written, std::string &error) {
+        stream.next_out = reinterpret_cast<Bytef*>(out);
+        stream.avail_out = static_cast<uInt>(space < UINT_MAX ? space : UINT_MAX);
+        uInt available = stream.avail_out;
+        while (stream.avail_out > 0) {
+            if (stream.avail_in == 0) {
+                if (remaining == 0) {
+                    if (!pending) {
+                        break;
+                    }
+                } else {
+                    uInt piece = static_cast<uInt>(remaining < UINT_MAX ? remaining : UINT_MAX);
+                    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(next));
+                    stream.avail_in = piece;
+                    next += piece;
+                    remaining -= piece;
+                }
+            }
+            if (ended) {
+                // Another gzip member or trailing garbage.
+                if (!isGzip(reinterpret_cast<const char*>(stream.next_in), stream.avail_in)) {
+                    stream.avail_in = 0;
+                    remaining = 0;
+                    break;
+                }
+                inflateReset(&stream);
+                ended = false;
+            }
+            int status = inflate(&stream, Z_NO_FLUSH);
+            // zlib may keep output of the used input
+            // when the space is full. It is read by
+            // the next call even without more input.
+            pending = status == Z_OK && stream.avail_out == 0;
+            if (status == Z_STREAM_END) {
+                ended = true;
+            } else if (status != Z_OK && status != Z_BUF_ERROR) {
+                error = "Error: invalid compressed data";
+                if (stream.msg) {
+                    error += ": ";
+                    error += stream.msg;
+                }
+                return false;
+            }
+        }
+        *written = available - stream.avail_out;
+        return true;
+    }
+
+private:
+    z_stream stream;
+    bool started;
+    bool ended;
+    // Whether the last call filled the space,
+    // so that more output may be pending.
+    bool pending;
+    const char *next;
+    size_t remaining;
+
+    Inflater(const Inflater&);
+    Inflater &operator=(const Inflater&);
+};
+
+// Splits the feed given in chunks into the feed
+// header and items. Tracks the lexical state
+// (tags, comments, CDATA sections) across chunks
+// so that the input can be split at any byte.
+// Complete items are parsed in-situ and the
+// consumed input is dropped. The buffer keeps at
+// most the header or the current item. The input
+// outside the items is kept to parse the feed
+// properties after the items at the end. Items
+// are taken from the first RSS channel only, like
+// parseFeed does. Does not use V8.
+
+class FeedSplitter {
+public:
+    FeedSplitter(const ParseOptions &options)
+        : options(options), compression(options.compression), inflater(0), headerDone(false),
+        type(TYPE_NONE), state(STATE_TEXT), pos(0), consumed(0), depth(0), inItem(false),
+        itemStart(0), itemLevel(0), itemCount(0), outsideStart(0), channelDone(false) {}
+
+    ~FeedSplitter() {
+        delete inflater;
+    }
+
+    // Appends the chunk and extracts the completed
+    // items into items(). The extracted values are
+    // valid until the next call. Returns false and
+    // sets the error message when parsing fails.
+    // Compressed chunks are inflated into the buffer.
+    bool write(const char *chunk, size_t length, std::string &error) {
+        compact();
+        if (compression == COMPRESSION_AUTO || compression == COMPRESSION_DEFLATE) {
+            // The header might be split.
+            pending.append(chunk, length);
+            if (pending.size() < 2) {
+                return true;
+            }
+            compression = detectCompression(pending.data(), pending.size(), compression);
+            std::string first;
+            first.swap(pending);
+            return append(first.data(), first.size(), error) && scan(error);
+        }
+        return append(chunk, length, error) && scan(error);
+    }
+
+    // Checks that the whole feed was given and
+    // extracts the header. The header is parsed
+    // again with the feed properties after the items.
+    bool end(std::string &error) {
+        compact();
+        if (!pending.empty()) {
+            // Too short to be compressed.
+            compression = COMPRESSION_NONE;
+            std::string first;
+            first.swap(pending);
+            if (!append(first.data(), first.size(), error) || !scan(error)) {
+                return false;
+            }
+            compact();
+        }
+        if (inflater && !inflater->finished()) {
+            error = "Error: unexpected end of compressed data";
+            return false;
+        }
+        if (state != STATE_TEXT || pos < buffer.size() || depth > 0) {
+            error = "Error: unexpected end of data";
+            return false;
+        }
+        if (type == TYPE_NONE) {
+            error = "Invalid feed.";
+            return false;
+        }
+        if (!headerDone) {
+            return parseHeader(buffer.size(), error);
+        }
+        keepOutside(buffer.size());
+        closeElements(outside, channelStack);
+        outside.push_back('\0');
+        headerXml.swap(outside);
+        outside.clear();
+        head.clear();
+        return parseFeed(&headerXml[0], head, options, error);
+    }
+
+    // Whether the header has been extracted.
+    bool hasHeader() const {
+        return headerDone;
+    }
+
+    // Feed properties without the items.
+    const Feed &header() const {
+        return head;
+    }
+
+    // Whether the feed is an Atom feed.
+    bool isAtom() const {
+        return type == TYPE_ATOM;
+    }
+
+    // Items extracted by the last call.
+    const Feed &items() const {
+        return batch;
+    }
+
+private:
+    enum Type {
+        TYPE_NONE,
+        TYPE_RSS,
+        TYPE_ATOM
+    };
+
+    enum State {
+        STATE_TEXT,
+        STATE_COMMENT,
+        STATE_CDATA,
+        STATE_PI
+    };
+
+    // Appends the chunk to the buffer. Compressed
+    // chunks are inflated straight into the buffer.
+    bool append(const char *chunk, size_t length, std::string &error) {
+        if (compression == COMPRESSION_NONE) {
+            buffer.reserve(buffer.size() + length + 1);
+            buffer.insert(buffer.end(), chunk, chunk + length);
+            return true;
+        }
+        if (!inflater) {
+            inflater = new Inflater();
+            if (!inflater->start(compression, error)) {
+                return false;
+            }
+        }
+        inflater->feed(chunk, length);
+        while (!inflater->used()) {
+            size_t size = buffer.size();
+            size_t space = length * 4 + 4096;
+            buffer.resize(size + space);
+            size_t written = 0;
+            bool ok = inflater->read(&buffer[size], space, &written, error);
+            buffer.resize(size + written);
+            if (!ok) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Drops the consumed input and the
+    // items extracted by the last call.
+    void compact() {
+        batch.items.clear();
+        if (consumed > 0) {
+            buffer.erase(buffer.begin(), buffer.begin() + consumed);
+            pos -= consumed;
+            itemStart -= inItem ? consumed : 0;
+            outsideStart -= consumed;
+            consumed = 0;
+        }
+    }
+
+    // Keeps the input outside the items up to the
+    // end. Whitespace between the items is dropped.
+    // Nothing is kept after the first RSS channel.
+    void keepOutside(size_t end) {
+        for (size_t i = outsideStart; i < end && !channelDone; i++) {
+            char c = buffer[i];
+            if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+                outside.insert(outside.end(), buffer.begin() + outsideStart, buffer.begin() + end);
+                break;
+            }
+        }
+        outsideStart = end;
+    }
+
+    // Appends the end tags of the open elements.
+    static void closeElements(std::vector<char> &xml, const std::vector<std::string> &open) {
+        for (size_t i = open.size(); i > 0; i--) {
+            xml.push_back('<');
+            xml.push_back('/');
+            xml.insert(xml.end(), open[i - 1].begin(), open[i - 1].end());
+            xml.push_back('>');
+        }
+    }
+
+    // Skips until the end of the comment, CDATA
+    // section or processing instruction. Keeps the
+    // position before a possibly partial terminator.
+    bool skipUntil(const char *token, size_t length) {
+        size_t found = findToken(&buffer[0], pos, buffer.size(), token, length);
+        if (found == buffer.size()) {
+            if (buffer.size() - pos >= length) {
+                pos = buffer.size() - length + 1;
+            }
+            return false;
+        }
+        pos = found + length;
+        state = STATE_TEXT;
+        return true;
+    }
+
+    // Finds the end of the markup declaration such
+    // as <!DOCTYPE> that might contain an internal
+    // subset in brackets. Returns the end.
+    size_t findDeclarationEnd(size_t start) const {
+        int brackets = 0;
+        char quote = 0;
+        for (size_t i = start; i < buffer.size(); i++) {
+            char c = buffer[i];
+            if (quote) {
+                if (c == quote) {
+                    quote = 0;
+                }
+            } else if (c == '"' || c == '\'') {
+                quote = c;
+            } else if (c == '[') {
+                brackets++;
+            } else if (c == ']') {
+                brackets--;
+            } else if (c == '>' && brackets <= 0) {
+                return i;
+            }
+        }
+        return buffer.size();
+    }
+
+    // Finds the end of the tag. Skips the
+    // quoted attribute values. Returns the end.
+    size_t findTagEnd(size_t start) const {
+        char quote = 0;
+        for (size_t i = start; i < buffer.size(); i++) {
+            char c = buffer[i];
+            if (quote) {
+                if (c == quote) {
+                    quote = 0;
+                }
+            } else if (c == '"' || c == '\'') {
+                quote = c;
+            } else if (c == '>') {
+                return i;
+            }
+        }
+        return buffer.size();
+    }
+
+    // Scans the buffer from the current position.
+    // Stops before a partial tag to continue from
+    // it once there is more input.
+    bool scan(std::string &error) {
+        while (pos < buffer.size()) {
+            if (state == STATE_COMMENT) {
+                if (!skipUntil("-->", 3)) {
+                    break;
+                }
+                continue;
+            }
+            if (state == STATE_CDATA) {
+                if (!skipUntil("]]>", 3)) {
+                    break;
+                }
+                continue;
+            }
+            if (state == STATE_PI) {
+                if (!skipUntil("?>", 2)) {
+                    break;
+                }
+                continue;
+            }
+            const char *start = &buffer[0];
+            const char *open = static_cast<const char*>(memchr(start + pos, '<', buffer.size() - pos));
+            if (!open) {
+                pos = buffer.size();
+                break;
+            }
+            pos = open - start;
+            size_t available = buffer.size() - pos;
+            if (available < 2) {
+                break;
+            }
+            char next = buffer[pos + 1];
+            if (next == '?') {
+                state = STATE_PI;
+                pos += 2;
+            } else if (next == '!') {
+                if (available < 4) {
+                    break;
+                }
+                if (memcmp(open, "<!--", 4) == 0) {
+                    state = STATE_COMMENT;
+                    pos += 4;
+                } else if (buffer[pos + 2] == '[') {
+                    if (available < 9) {
+                        break;
+                    }
+                    if (memcmp(open, "<![CDATA[", 9) != 0) {
+                        error = "Error: invalid markup";
+                        return false;
+                    }
+                    state = STATE_CDATA;
+                    pos += 9;
+                } else {
+                    size_t end = findDeclarationEnd(pos + 2);
+                    if (end == buffer.size()) {
+                        break;
+                    }
+                    pos = end + 1;
+                }
+            } else {
+                size_t end = findTagEnd(pos + 1);
+                if (end == buffer.size()) {
+                    break;
+                }
+                bool ok = next == '/' ? endTag(end, error) : startTag(end, error);
+                if (!ok) {
+                    return false;
+                }
+                pos = end + 1;
+            }
+        }
+        if (headerDone) {
+            // The input after the last item is
+            // kept until the next item or the end.
+            if (channelDone) {
+                keepOutside(pos);
+            }
+            consumed = outsideStart;
+        }
+        return true;
+    }
+
+    // Handles the start tag between the
+    // current position and the end.
+    bool startTag(size_t end, std::string &error) {
+        bool empty = buffer[end - 1] == '/';
+        if (inItem) {
+            depth += empty ? 0 : 1;
+            return true;
+        }
+        size_t nameEnd = pos + 1;
+        while (nameEnd < end && buffer[nameEnd] != ' ' && buffer[nameEnd] != '\t' &&
+            buffer[nameEnd] != '\n' && buffer[nameEnd] != '\r' && buffer[nameEnd] != '/') {
+            nameEnd++;
+        }
+        std::string name(&buffer[pos + 1], nameEnd - pos - 1);
+        if (type == TYPE_NONE) {
+            if (name == "rss") {
+                type = TYPE_RSS;
+            } else if (name == "feed") {
+                type = TYPE_ATOM;
+            } else {
+                error = "Invalid feed.";
+                return false;
+            }
+        }
+        bool isItem = (type == TYPE_ATOM && depth == 1 && name == "entry") ||
+            (type == TYPE_RSS && depth == 2 && !channelDone && stack[1] == "channel" && name == "item");
+        if (isItem) {
+            if (!headerDone && !parseHeader(pos, error)) {
+                return false;
+            }
+            keepOutside(pos);
+            if (empty) {
+                return parseItem(pos, end + 1, error);
+            }
+            inItem = true;
+            itemStart = pos;
+            itemLevel = depth;
+            depth++;
+            return true;
+        }
+        if (!empty) {
+            stack.push_back(name);
+            depth++;
+        }
+        return true;
+    }
+
+    // Handles the end tag. Parses the
+    // item when it is complete.
+    bool endTag(size_t end, std::string &error) {
+        if (depth == 0) {
+            error = "Error: unexpected end tag";
+            return false;
+        }
+        depth--;
+        if (inItem) {
+            if (depth == itemLevel) {
+                inItem = false;
+                return parseItem(itemStart, end + 1, error);
+            }
+            return true;
+        }
+        bool channel = stack.back() == "channel";
+        stack.pop_back();
+        if (type == TYPE_RSS && depth == 1 && channel && !channelDone) {
+            // The first channel ends.
+            if (headerDone) {
+                keepOutside(end + 1);
+            }
+            channelDone = true;
+            channelStack = stack;
+        }
+        return true;
+    }
+
+    // Parses the header from the input before the
+    // first item. The open elements are closed.
+    bool parseHeader(size_t end, std::string &error) {
+        headerXml.assign(buffer.begin(), buffer.begin() + end);
+        outside.assign(buffer.begin(), buffer.begin() + end);
+        outsideStart = end;
+        closeElements(headerXml, stack);
+        headerXml.push_back('\0');
+        headerDone = true;
+        return parseFeed(&headerXml[0], head, options, error);
+    }
+
+    // Parses the item between the positions in-situ.
+    // The write reserves the space for the terminator
+    // so that the earlier items are not moved.
+    bool parseItem(size_t start, size_t end, std::string &error) {
+        itemCount++;
+        bool last = end == buffer.size();
+        char saved = last ? '\0' : buffer[end];
+        if (last) {
+            buffer.push_back('\0');
+        } else {
+            buffer[end] = '\0';
+        }
+        doc.clear();
+        try {
+            parseDocument(doc, &buffer[start], options);
+        } catch(rapidxml::parse_error &e) {
+            std::stringstream err;
+            err << "Error in item " << itemCount << ": " << e.what();
+            error = err.str();
+            return false;
+        }
+        if (last) {
+            buffer.pop_back();
+        } else {
+            buffer[end] = saved;
+        }
+        outsideStart = end;
+        batch.items.push_back(Item());
+        if (type == TYPE_ATOM) {
+            parseAtomItem(doc.first_node(), batch.items.back(), options.itemFields());
+        } else {
+            parseRssItem(doc.first_node(), batch.items.back(), options.itemFields());
+        }
+        return true;
+    }
+
+    ParseOptions options;
+    Compression compression;
+    Inflater *inflater;
+    // Start of the input until the
+    // compression is known.
+    std::string pending;
+    std::vector<char> buffer;
+    std::vector<char> headerXml;
+    // Input outside the items from the
+    // start of the feed.
+    std::vector<char> outside;
+    std::vector<std::string> stack;
+    xml_document<char> doc;
+    bool headerDone;
+    Feed head;
+    Feed batch;
+    Type type;
+    State state;
+    size_t pos;
+    size_t consumed;
+    size_t depth;
+    bool inItem;
+    size_t itemStart;
+    size_t itemLevel;
+    size_t itemCount;
+    size_t outsideStart;
+    bool channelDone;
+    // Elements open after the first channel.
+    std::vector<std::string> channelStack;
+
+    FeedSplitter(const FeedSplitter&);
+    FeedSplitter &operator=(const FeedSplitter&);
+};
+
+// Finds the length of the ASCII-only prefix.
+// Checks 16 bytes at once with SSE2.
+
+inline size_t asciiPrefix(const char *data, size_t length) {
+    size_t i = 0;
+#if defined(RAPIDXML_SSE2)
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(block));
+        if (mask) {
+            return i + rapidxml::internal::lowest_bit(mask);
+        }
+    }
+#endif
+    for (; i < length; i++) {
+        if (data[i] & 0x80) {
+            break;
+        }
+    }
+    return i;
+}
+
+// Finds the encoding from the XML declaration.
+// Inputs without the declaration are UTF-8.
+// A declared UTF-16 cannot be right when the
+// declaration itself was readable as ASCII.
+
+inline Charset declaredCharset(const char *data, size_t length) {
+    if (length < 5 || memcmp(data, "<?xml", 5) != 0) {
+        return CHARSET_UTF8;
+    }
+    size_t limit = findToken(data, 0, length < 1024 ? length : 1024, "?>", 2);
+    size_t attribute = findToken(data, 0, limit, "encoding", 8);
+    if (attribute == limit) {
+        return CHARSET_UTF8;
+    }
+    const char *end = data + limit;
+    const char *p = data + attribute + 8;
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == '=')) {
+        p++;
+    }
+    if (p == end || (*p != '"' && *p != '\'')) {
+        return CHARSET_UTF8;
+    }
+    const char *name = p + 1;
+    const char *quote = static_cast<const char*>(memchr(name, *p, end - name));
+    if (!quote) {
+        return CHARSET_UTF8;
+    }
+    Charset charset = findCharset(name, quote - name);
+    if (charset == CHARSET_WINDOWS_1252) {
+        return charset;
+    }
+    return CHARSET_UTF8;
+}
+
+// Detects the encoding of the input. The byte order
+// mark takes precedence over the hint given by the
+// caller, the hint over the XML declaration. Sets the
+// length of the byte order mark to skip.
+
+inline Charset detectCharset(const char *data, size_t length, Charset hint, size_t *skip) {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>(data);
+    *skip = 0;
+    if (length >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF) {
+        *skip = 3;
+        return CHARSET_UTF8;
+    }
+    if (length >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE) {
+        *skip = 2;
+        return CHARSET_UTF16LE;
+    }
+    if (length >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF) {
+        *skip = 2;
+        return CHARSET_UTF16BE;
+    }
+    // UTF-16 without the byte order mark.
+    if (length >= 4 && bytes[0] == '<' && bytes[1] == 0 && bytes[2] == '?' && bytes[3] == 0) {
+        return CHARSET_UTF16LE;
+    }
+    if (length >= 4 && bytes[0] == 0 && bytes[1] == '<' && bytes[2] == 0 && bytes[3] == '?') {
+        return CHARSET_UTF16BE;
+    }
+    if (hint == CHARSET_UTF16) {
+        return CHARSET_UTF16BE;
+    }
+    if (hint != CHARSET_AUTO) {
+        return hint;
+    }
+    return declaredCharset(data, length);
+}
+
+// Encodes the code point as UTF-8.
+// Returns the number of bytes written.
+
+inline size_t writeUtf8(unsigned int code, char *out) {
+    if (code < 0x80) {
+        out[0] = static_cast<char>(code);
+        return 1;
+    } else if (code < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (code >> 6));
+        out[1] = static_cast<char>(0x80 | (code & 0x3F));
+        return 2;
+    } else if (code < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (code >> 12));
+        out[1] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (code & 0x3F));
+        return 3;
+    } else {
+        out[0] = static_cast<char>(0xF0 | (code >> 18));
+        out[1] = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out[2] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out[3] = static_cast<char>(0x80 | (code & 0x3F));
+        return 4;
+    }
+}
+
+// Code points of windows-1252 bytes 0x80-0x9F.
+// Unassigned bytes map to the C1 controls.
+
+static const uint16_t WINDOWS_1252[32] = {
+    0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+    0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178
+};
+
+// Transcodes windows-1252 into UTF-8. The output
+// needs 3 bytes per input byte in the worst case.
+// ASCII runs are copied as they are.
+
+inline size_t transcodeWindows1252(const char *data, size_t length, char *out) {
+    const char *start = out;
+    size_t i = 0;
+    while (i < length) {
+        size_t ascii = asciiPrefix(data + i, length - i);
+        memcpy(out, data + i, ascii);
+        out += ascii;
+        i += ascii;
+        if (i < length) {
+            unsigned int c = static_cast<unsigned char>(data[i++]);
+            out += writeUtf8(c < 0xA0 ? WINDOWS_1252[c - 0x80] : c, out);
+        }
+    }
+    return out - start;
+}
+
+// Transcodes UTF-16 into UTF-8. The output needs
+// 3 bytes per 2 input bytes in the worst case.
+// Unpaired surrogates are replaced with U+FFFD.
+
+inline size_t transcodeUtf16(const char *data, size_t length, bool bigEndian, char *out) {
+    const unsigned char *in = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char *end = in + (length & ~static_cast<size_t>(1));
+    const char *start = out;
+    int high = bigEndian ? 0 : 1;
+    while (in < end) {
+        unsigned int code = (in[high] << 8) | in[1 - high];
+        in += 2;
+        if (code >= 0xD800 && code < 0xDC00) {
+            unsigned int next = in < end ? ((in[high] << 8) | in[1 - high]) : 0;
+            if (next >= 0xDC00 && next < 0xE000) {
+                code = 0x10000 + ((code - 0xD800) << 10) + (next - 0xDC00);
+                in += 2;
+            } else {
+                code = 0xFFFD;
+            }
+        } else if (code >= 0xDC00 && code < 0xE000) {
+            code = 0xFFFD;
+        }
+        out += writeUtf8(code, out);
+    }
+    if (length & 1) {
+        out += writeUtf8(0xFFFD, out);
+    }
+    return out - start;
+}
+
+// Largest output buffer allocated up front
+// from the gzip trailer.
+static const size_t INFLATE_HINT_LIMIT = 64 * 1024 * 1024;
+
+// Input buffer of a parse. Keeps the compressed or
+// converted bytes and the terminating nul. The input
+// is parsed in-situ.
+//
+// The lenient mode derives the input again from its
+// source when the in-situ parse fails, so that
+// well-formed feeds are not copied. The source is
+// the bytes given to assignBytes, which must stay
+// valid until the parse is done, or the compressed
+// bytes kept by decompress.
+
+class Input {
+public:
+    Input() : charset(CHARSET_AUTO), compression(COMPRESSION_NONE), buffer(0), length(0), allocated(0),
+        source(0), sourceLength(0), sourceCharset(CHARSET_AUTO), sourceCompression(COMPRESSION_NONE),
+        ownedSource(0) {}
+
+    virtual ~Input() {
+        free(buffer);
+        free(ownedSource);
+    }
+
+    char *data() {
+        return buffer;
+    }
+
+    // Sets the input length. Reuses the buffer when
+    // it is large enough. Returns the buffer to write
+    // the input to. The terminating nul is set.
+    char *resize(size_t size) {
+        if (size + 1 > allocated) {
+            free(buffer);
+            allocated = size + 1;
+            buffer = static_cast<char*>(malloc(allocated));
+            if (!buffer) {
+                throw std::bad_alloc();
+            }
+        }
+        length = size;
+        buffer[length] = '\0';
+        return buffer;
+    }
+
+    // Shortens the input after writing
+    // less than reserved by resize.
+    void truncate(size_t size) {
+        length = size;
+        buffer[length] = '\0';
+    }
+
+    // Copies the bytes. Compressed bytes are kept
+    // as they are until decompress is called. The
+    // bytes become the source of the input.
+    void assignBytes(const char *data, size_t size, Charset hint, Compression option) {
+        setSource(data, size, hint, option);
+        copyBytes(data, size, hint, option);
+    }
+
+    // Sets the bytes the input is derived from again
+    // by restore. They must stay valid until the
+    // parse is done.
+    void setSource(const char *data, size_t size, Charset hint, Compression option) {
+        free(ownedSource);
+        ownedSource = 0;
+        source = data;
+        sourceLength = size;
+        sourceCharset = hint;
+        sourceCompression = option;
+    }
+
+    // Makes the input its own source when the
+    // assigned bytes do not stay valid. Copies
+    // the input unless it is compressed.
+    void copySource() {
+        clearSource();
+        if (compression != COMPRESSION_NONE) {
+            // Kept by decompress.
+            return;
+        }
+        char *copy = static_cast<char*>(malloc(length + 1));
+        if (!copy) {
+            throw std::bad_alloc();
+        }
+        memcpy(copy, buffer, length);
+        setSource(copy, length, CHARSET_UTF8, COMPRESSION_NONE);
+        ownedSource = copy;
+    }
+
+    // Forgets the source after the parse.
+    virtual void clearSource() {
+        setSource(0, 0, CHARSET_AUTO, COMPRESSION_NONE);
+    }
+
+    // Derives the input again from its source.
+    // Returns false when there is no source or
+    // the source cannot be decompressed.
+    virtual bool restore(std::string &error) {
+        if (!source) {
+            return false;
+        }
+        // Keeps the owned source while copying it.
+        char *owned = ownedSource;
+        ownedSource = 0;
+        copyBytes(source, sourceLength, sourceCharset, sourceCompression);
+        ownedSource = owned;
+        return decompress(error);
+    }
+
+    // Copies the bytes. Compressed bytes are kept
+    // as they are until decompress is called.
+    void copyBytes(const char *data, size_t size, Charset hint, Compression option) {
+        charset = hint;
+        compression = detectCompression(data, size, option);
+        if (compression == COMPRESSION_NONE) {
+            convert(data, size, hint);
+        } else {
+            memcpy(resize(size), data, size);
+        }
+    }
+
+    // Copies the bytes converted into UTF-8.
+    void convert(const char *data, size_t size, Charset hint) {
+        size_t skip;
+        Charset charset = detectCharset(data, size, hint, &skip);
+        data += skip;
+        size -= skip;
+        if (charset == CHARSET_WINDOWS_1252) {
+            truncate(transcodeWindows1252(data, size, resize(size * 3)));
+        } else if (charset == CHARSET_UTF16LE || charset == CHARSET_UTF16BE) {
+            truncate(transcodeUtf16(data, size, charset == CHARSET_UTF16BE, resize(size / 2 * 3 + 3)));
+        } else {
+            memcpy(resize(size), data, size);
+        }
+    }
+
+    // Inflates the compressed input and converts
+    // it into UTF-8. Runs on any thread. Returns false
+    // and sets the error on invalid compressed data.
+    // The compressed bytes become the source when
+    // there is none.
+    bool decompress(std::string &error) {
+        if (compression == COMPRESSION_NONE) {
+            return true;
+        }
+        char *compressed = buffer;
+        size_t compressedLength = length;
+        buffer = 0;
+        length = 0;
+        allocated = 0;
+        bool ok = inflate(compressed, compressedLength, error);
+        if (source) {
+            free(compressed);
+        } else {
+            setSource(compressed, compressedLength, charset, compression);
+            ownedSource = compressed;
+        }
+        compression = COMPRESSION_NONE;
+        if (!ok) {
+            resize(0);
+            return false;
+        }
+        size_t skip;
+        Charset detected = detectCharset(buffer, length, charset, &skip);
+        if (detected == CHARSET_WINDOWS_1252 || detected == CHARSET_UTF16LE || detected == CHARSET_UTF16BE) {
+            char *inflated = buffer;
+            size_t inflatedLength = length;
+            buffer = 0;
+            allocated = 0;
+            convert(inflated, inflatedLength, charset);
+            free(inflated);
+        } else if (skip > 0) {
+            memmove(buffer, buffer + skip, length - skip + 1);
+            length -= skip;
+        }
+        return true;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    size_t capacity() const {
+        return allocated;
+    }
+
+protected:
+    // Encoding hint and compression of
+    // the input until decompressed.
+    Charset charset;
+    Compression compression;
+
+private:
+    // Grows the buffer keeping the contents.
+    void grow(size_t size) {
+        char *grown = static_cast<char*>(realloc(buffer, size));
+        if (!grown) {
+            throw std::bad_alloc();
+        }
+        buffer = grown;
+        allocated = size;
+    }
+
+    // Inflates the source into the buffer. The size
+    // of a single gzip member is in its trailer. The
+    // trailer is set by the sender, so it is only used
+    // as a hint limited by the largest deflate ratio
+    // (1032:1) and INFLATE_HINT_LIMIT. The buffer grows
+    // from there.
+    bool inflate(const char *source, size_t sourceLength, std::string &error) {
+        Inflater inflater;
+        if (!inflater.start(compression, error)) {
+            return false;
+        }
+        inflater.feed(source, sourceLength);
+        size_t expected = sourceLength * 4;
+        if (isGzip(source, sourceLength) && sourceLength >= 18) {
+            const unsigned char *trailer = reinterpret_cast<const unsigned char*>(source + sourceLength - 4);
+            size_t size = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | (static_cast<size_t>(trailer[3]) << 24);
+            size = std::min(size, std::min(sourceLength * 1032, INFLATE_HINT_LIMIT));
+            if (size > 0) {
+                expected = size;
+            }
+        }
+        // Room for the terminating nul and for
+        // reading the trailer after the data.
+        grow(expected + 64);
+        while (!inflater.used()) {
+            if (allocated - length < 64) {
+                grow(allocated * 2);
+            }
+            size_t written = 0;
+            if (!inflater.read(buffer + length, allocated - length - 1, &written, error)) {
+                return false;
+            }
+            length += written;
+        }
+        if (!inflater.finished()) {
+            error = "Error: unexpected end of compressed data";
+            return false;
+        }
+        buffer[length] = '\0';
+        return true;
+    }
+
+    char *buffer;
+    size_t length;
+    size_t allocated;
+    // Source of the input and its encoding hint
+    // and compression option. The owned source
+    // is freed with the input.
+    const char *source;
+    size_t sourceLength;
+    Charset sourceCharset;
+    Compression sourceCompression;
+    char *ownedSource;
+
+    Input(const Input&);
+    Input &operator=(const Input&);
+};
+
+// Decompresses and parses the input. In the lenient
+// mode the input is repaired and parsed again when it
+// is not well-formed. Parsing is in-situ, so the repair
+// works on the input derived again from its source.
+// With the stats option the decompression and the
+// repair count as parsing.
+
+inline bool decompressAndParse(xml_document<char> &doc, Input &input, Feed &feed, const ParseOptions &options,
+    std::string &error) {
+    if (options.stats) {
+        feed.stats.inputBytes = input.size();
+        uint64_t start = monotonicNs();
+        if (!input.decompress(error)) {
+            return false;
+        }
+        feed.stats.parseNs = monotonicNs() - start;
+    } else if (!input.decompress(error)) {
+        return false;
+    }
+    if (!options.lenient) {
+        return parseFeed(doc, input.data(), feed, options, error);
+    }
+    if (parseFeed(doc, input.data(), feed, options, error)) {
+        return true;
+    }
+    // The stats include the failed parse.
+    ParseStats stats = feed.stats;
+    feed.clear();
+    feed.stats = stats;
+    uint64_t start = options.stats ? monotonicNs() : 0;
+    // Keeps the parse error when the input
+    // cannot be derived again.
+    std::string restoreError;
+    if (!input.restore(restoreError)) {
+        return false;
+    }
+    std::vector<char> repaired;
+    XmlRepair(input.data(), input.size(), feed.warnings).run(repaired);
+    if (!repaired.empty()) {
+        memcpy(input.resize(repaired.size()), &repaired[0], repaired.size());
+    }
+    if (options.stats) {
+        feed.stats.parseNs += monotonicNs() - start;
+    }
+    return parseFeed(doc, input.data(), feed, options, error);
+}
+
+// Same as decompressAndParse but returns the error
+// when memory runs out instead of throwing. Runs on
+// any thread.
+
+inline bool parseInput(xml_document<char> &doc, Input &input, Feed &feed, const ParseOptions &options,
+    std::string &error) {
+    bool ok;
+    try {
+        ok = decompressAndParse(doc, input, feed, options, error);
+    } catch(std::bad_alloc &e) {
+        doc.clear();
+        feed.clear();
+        error = OUT_OF_MEMORY;
+        ok = false;
+    }
+    input.clearSource();
+    return ok;
+}
+
+// Reusable parser for C++ callers. Keeps the input
+// buffer and the document memory between parses.
+// The extracted feed points into the input and is
+// valid until the next parse.
+
+class FeedParser {
+public:
+    FeedParser(const ParseOptions &options, size_t highWaterMark = 4 * 1024 * 1024)
+        : options(options), cache(highWaterMark) {
+        doc.set_allocator(allocateBlock, releaseBlock);
+    }
+
+    ~FeedParser() {
+        CacheScope scope(&cache);
+        doc.clear();
+    }
+
+    // Parses the bytes. Returns false and sets
+    // the error message when parsing fails.
+    bool parse(const char *data, size_t size) {
+        CacheScope scope(&cache);
+        result.clear();
+        error.clear();
+        input.assignBytes(data, size, options.charset, options.compression);
+        bool ok = parseInput(doc, input, result, options, error);
+        doc.clear();
+        cache.trim();
+        return ok;
+    }
+
+    const Feed &feed() const {
+        return result;
+    }
+
+    const std::string &lastError() const {
+        return error;
+    }
+
+private:
+    ParseOptions options;
+    BlockCache cache;
+    Input input;
+    xml_document<char> doc;
+    Feed result;
+    std::string error;
+
+    FeedParser(const FeedParser&);
+    FeedParser &operator=(const FeedParser&);
+};
+
+}
+
+#endif
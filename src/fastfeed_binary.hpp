@@ -0,0 +1,317 @@
+#ifndef FASTFEED_BINARY_HPP_INCLUDED
+#define FASTFEED_BINARY_HPP_INCLUDED
+
+// Writes the extracted feed into a flat binary
+// buffer. The buffer has no pointers and can be
+// moved between threads and processes as it is.
+// The layout is described in README.md and read
+// by binary.js. All numbers are little-endian.
+
+#include "fastfeed.hpp"
+
+namespace fastfeed {
+
+// Layout version 1.
+
+static const uint32_t BINARY_MAGIC = 0x31424646; // "FFB1"
+static const uint32_t BINARY_VERSION = 1;
+static const uint32_t BINARY_NONE = 0xFFFFFFFF;
+static const size_t BINARY_HEADER_SIZE = 40;
+// Title, id, link, description, author,
+// author_uri and author_email.
+static const size_t BINARY_FEED_FIELDS = 7;
+// Id, title, link, date, description, summary,
+// content, author, author_uri, author_email,
+// enclosure url and enclosure type.
+static const size_t BINARY_ITEM_FIELDS = 12;
+static const size_t BINARY_ITEM_SIZE = BINARY_ITEM_FIELDS * 8 + 32;
+static const size_t BINARY_LINK_FIELDS = 7;
+
+class BinaryWriter {
+public:
+    BinaryWriter(const Feed &feed) : feed(feed), out(0), lists(0), heap(0), listWords(0), heapBytes(0) {
+        measure();
+    }
+
+    // Size of the buffer. Larger than 4GB
+    // results cannot be written.
+    size_t size() const {
+        return listsOffset() + listWords * 4 + heapBytes;
+    }
+
+    bool fits() const {
+        return size() <= 0xFFFFFFFFu;
+    }
+
+    // Writes the feed into the buffer
+    // of size() bytes.
+    void write(char *buffer) {
+        out = buffer;
+        lists = 0;
+        heap = 0;
+        memset(out, 0, listsOffset());
+        size_t heapOffset = listsOffset() + listWords * 4;
+        put32(0, BINARY_MAGIC);
+        put32(4, BINARY_VERSION);
+        put32(8, feed.atom ? 1 : 0);
+        put32(12, static_cast<uint32_t>(feed.items.size()));
+        put32(16, static_cast<uint32_t>(itemsOffset()));
+        put32(20, static_cast<uint32_t>(listsOffset()));
+        put32(24, static_cast<uint32_t>(heapOffset));
+        put32(28, static_cast<uint32_t>(heapBytes));
+        put32(32, writeExtensions(feed.extensions));
+        put32(36, writeWarnings());
+        size_t pos = BINARY_HEADER_SIZE;
+        putText(pos, feed.title);
+        putText(pos + 8, feed.id);
+        putText(pos + 16, feed.link);
+        putText(pos + 24, feed.description);
+        putText(pos + 32, feed.author.name);
+        putText(pos + 40, feed.author.uri);
+        putText(pos + 48, feed.author.email);
+        for (size_t i = 0; i < feed.items.size(); i++) {
+            writeItem(itemsOffset() + i * BINARY_ITEM_SIZE, feed.items[i]);
+        }
+    }
+
+private:
+    size_t itemsOffset() const {
+        return BINARY_HEADER_SIZE + BINARY_FEED_FIELDS * 8;
+    }
+
+    size_t listsOffset() const {
+        return itemsOffset() + feed.items.size() * BINARY_ITEM_SIZE;
+    }
+
+    // Counts the list words and the heap bytes.
+    void measure() {
+        measureText(feed.title);
+        measureText(feed.id);
+        measureText(feed.link);
+        measureText(feed.description);
+        measureAuthor(feed.author);
+        measureExtensions(feed.extensions);
+        if (!feed.warnings.empty()) {
+            listWords += 1 + feed.warnings.size() * 2;
+            for (size_t i = 0; i < feed.warnings.size(); i++) {
+                heapBytes += feed.warnings[i].size();
+            }
+        }
+        for (size_t i = 0; i < feed.items.size(); i++) {
+            const Item &item = feed.items[i];
+            measureText(item.id);
+            measureText(item.title);
+            measureText(item.link);
+            measureText(item.date);
+            measureText(item.description);
+            measureText(item.summary);
+            measureText(item.content);
+            measureAuthor(item.author);
+            measureText(item.enclosure.url);
+            measureText(item.enclosure.type);
+            if (!item.categories.empty()) {
+                listWords += 1 + item.categories.size() * 2;
+                for (size_t j = 0; j < item.categories.size(); j++) {
+                    measureText(item.categories[j]);
+                }
+            }
+            if (!item.links.empty()) {
+                listWords += 1 + item.links.size() * BINARY_LINK_FIELDS * 2;
+                for (size_t j = 0; j < item.links.size(); j++) {
+                    const Link &link = item.links[j];
+                    measureText(link.rel);
+                    measureText(link.href);
+                    measureText(link.type);
+                    measureText(link.hreflang);
+                    measureText(link.title);
+                    measureText(link.length);
+                    measureText(link.text);
+                }
+            }
+            measureExtensions(item.extensions);
+        }
+    }
+
+    void measureText(const Text &text) {
+        heapBytes += text.length;
+    }
+
+    void measureAuthor(const Author &author) {
+        measureText(author.name);
+        measureText(author.uri);
+        measureText(author.email);
+    }
+
+    void measureExtensions(const std::vector<FeedExtension> &extensions) {
+        if (extensions.empty()) {
+            return;
+        }
+        listWords += 1;
+        for (size_t i = 0; i < extensions.size(); i++) {
+            const FeedExtension &extension = extensions[i];
+            listWords += 5 + extension.attributes.size() * 4;
+            measureText(extension.name);
+            measureText(extension.value);
+            for (size_t j = 0; j < extension.attributes.size(); j++) {
+                measureText(extension.attributes[j].first);
+                measureText(extension.attributes[j].second);
+            }
+        }
+    }
+
+    void writeItem(size_t pos, const Item &item) {
+        putText(pos, item.id);
+        putText(pos + 8, item.title);
+        putText(pos + 16, item.link);
+        putText(pos + 24, item.date);
+        putText(pos + 32, item.description);
+        putText(pos + 40, item.summary);
+        putText(pos + 48, item.content);
+        putText(pos + 56, item.author.name);
+        putText(pos + 64, item.author.uri);
+        putText(pos + 72, item.author.email);
+        putText(pos + 80, item.enclosure.url);
+        putText(pos + 88, item.enclosure.type);
+        pos += BINARY_ITEM_FIELDS * 8;
+        putDouble(pos, item.dateParsed ? item.time : NAN);
+        putDouble(pos + 8, item.enclosure.hasLength ? static_cast<double>(item.enclosure.length) : NAN);
+        put32(pos + 16, item.enclosure.present ? 1 : 0);
+        put32(pos + 20, writeCategories(item.categories));
+        put32(pos + 24, writeLinks(item.links));
+        put32(pos + 28, writeExtensions(item.extensions));
+    }
+
+    // Lists are written in the lists area. Each
+    // starts with the number of entries. Returns
+    // the word index of the list.
+
+    uint32_t writeCategories(const std::vector<Text> &categories) {
+        if (categories.empty()) {
+            return BINARY_NONE;
+        }
+        uint32_t start = beginList(categories.size());
+        for (size_t i = 0; i < categories.size(); i++) {
+            listText(categories[i]);
+        }
+        return start;
+    }
+
+    uint32_t writeLinks(const std::vector<Link> &links) {
+        if (links.empty()) {
+            return BINARY_NONE;
+        }
+        uint32_t start = beginList(links.size());
+        for (size_t i = 0; i < links.size(); i++) {
+            const Link &link = links[i];
+            listText(link.rel);
+            listText(link.href);
+            listText(link.type);
+            listText(link.hreflang);
+            listText(link.title);
+            listText(link.length);
+            listText(link.text);
+        }
+        return start;
+    }
+
+    // Extension entries are the name, the value,
+    // the number of attributes and the attribute
+    // names and values.
+    uint32_t writeExtensions(const std::vector<FeedExtension> &extensions) {
+        if (extensions.empty()) {
+            return BINARY_NONE;
+        }
+        uint32_t start = beginList(extensions.size());
+        for (size_t i = 0; i < extensions.size(); i++) {
+            const FeedExtension &extension = extensions[i];
+            listText(extension.name);
+            listText(extension.value);
+            listWord(static_cast<uint32_t>(extension.attributes.size()));
+            for (size_t j = 0; j < extension.attributes.size(); j++) {
+                listText(extension.attributes[j].first);
+                listText(extension.attributes[j].second);
+            }
+        }
+        return start;
+    }
+
+    uint32_t writeWarnings() {
+        if (feed.warnings.empty()) {
+            return BINARY_NONE;
+        }
+        uint32_t start = beginList(feed.warnings.size());
+        for (size_t i = 0; i < feed.warnings.size(); i++) {
+            listText(Text(feed.warnings[i].data(), feed.warnings[i].size()));
+        }
+        return start;
+    }
+
+    uint32_t beginList(size_t count) {
+        uint32_t start = static_cast<uint32_t>(lists);
+        listWord(static_cast<uint32_t>(count));
+        return start;
+    }
+
+    void listWord(uint32_t value) {
+        put32(listsOffset() + lists * 4, value);
+        lists++;
+    }
+
+    void listText(const Text &text) {
+        uint32_t offset = heapText(text);
+        listWord(offset);
+        listWord(static_cast<uint32_t>(text.length));
+    }
+
+    // Copies the text into the heap. Returns its
+    // offset in the heap or BINARY_NONE when the
+    // value is missing.
+    uint32_t heapText(const Text &text) {
+        if (text.missing()) {
+            return BINARY_NONE;
+        }
+        uint32_t offset = static_cast<uint32_t>(heap);
+        memcpy(out + listsOffset() + listWords * 4 + heap, text.data, text.length);
+        heap += text.length;
+        return offset;
+    }
+
+    // Writes the string reference: the offset
+    // in the heap and the length in bytes.
+    void putText(size_t pos, const Text &text) {
+        put32(pos, heapText(text));
+        put32(pos + 4, static_cast<uint32_t>(text.length));
+    }
+
+    void put32(size_t pos, uint32_t value) {
+        unsigned char *bytes = reinterpret_cast<unsigned char*>(out + pos);
+        bytes[0] = value & 0xFF;
+        bytes[1] = (value >> 8) & 0xFF;
+        bytes[2] = (value >> 16) & 0xFF;
+        bytes[3] = (value >> 24) & 0xFF;
+    }
+
+    void putDouble(size_t pos, double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        put32(pos, static_cast<uint32_t>(bits));
+        put32(pos + 4, static_cast<uint32_t>(bits >> 32));
+    }
+
+    const Feed &feed;
+    char *out;
+    // Words written into the lists and
+    // bytes written into the heap.
+    size_t lists;
+    size_t heap;
+    // Sizes of the lists and the heap.
+    size_t listWords;
+    size_t heapBytes;
+
+    BinaryWriter(const BinaryWriter&);
+    BinaryWriter &operator=(const BinaryWriter&);
+};
+
+}
+
+#endif
@@ -1,10 +1,12 @@
 #include <node.h>
 #include <nan.h>
 #include <v8.h>
-#include <sstream>
+#include <memory>
+#include <string>
 #include <vector>
 #include <string.h>
-#include "rapidxml.hpp"
+#include "fastfeed.hpp"
+#include "fastfeed_binary.hpp"
 
 // Used example code from:
 // https://github.com/glynos/cpp-netlib/blob/master/contrib/http_examples/rss/rss.cpp
@@ -12,592 +14,1651 @@
 
 using namespace v8;
 using namespace rapidxml;
+using namespace fastfeed;
 
-char const *EMPTY_C_STRING = "";
-
-// Helper to read text node value.
-// Returns 0 when cannot read the value.
-
-char const *readTextNode(xml_node<char> *node, std::vector<char*> &deallocate) {
-    xml_node<char> *textNode = node->first_node();
-    if (textNode) {
-        // Checks for case of multiple
-        // consecutive CDATA nodes.
-        if (textNode->next_sibling()) {
-            // First calculate required buffer size.
-            size_t neededSpace = 0;
-            xml_node<char> *sibling = textNode;
-            while (sibling) {
-                neededSpace += strlen(sibling->value());
-                sibling = sibling->next_sibling();
+// Property names (and constant values) of
+// the output objects and names of the options.
+
+#define FEED_KEYS(X) \
+    X(TYPE, "type") \
+    X(ATOM, "atom") \
+    X(RSS, "rss") \
+    X(TITLE, "title") \
+    X(ID, "id") \
+    X(LINK, "link") \
+    X(LINKS, "links") \
+    X(DESCRIPTION, "description") \
+    X(AUTHOR, "author") \
+    X(AUTHOR_URI, "author_uri") \
+    X(AUTHOR_EMAIL, "author_email") \
+    X(ITEMS, "items") \
+    X(DATE, "date") \
+    X(DATE_RAW, "date_raw") \
+    X(SUMMARY, "summary") \
+    X(CONTENT, "content") \
+    X(REL, "rel") \
+    X(HREF, "href") \
+    X(HREFLANG, "hreflang") \
+    X(LENGTH, "length") \
+    X(TEXT, "text") \
+    X(CATEGORIES, "categories") \
+    X(NAME, "name") \
+    X(ENCLOSURE, "enclosure") \
+    X(URL, "url") \
+    X(EXTENSIONS, "extensions") \
+    X(VALUE, "value") \
+    X(ATTRIBUTES, "attributes") \
+    X(STABLE_SHAPE, "stableShape") \
+    X(TIMESTAMPS, "timestamps") \
+    X(RAW_DATES, "rawDates") \
+    X(CONCURRENCY, "concurrency") \
+    X(FIELDS, "fields") \
+    X(HIGH_WATER_MARK, "highWaterMark") \
+    X(EXTERNAL_STRINGS, "externalStrings") \
+    X(LAZY, "lazy") \
+    X(CHARSET, "charset") \
+    X(COMPRESSION, "compression") \
+    X(LENIENT, "lenient") \
+    X(WARNINGS, "warnings") \
+    X(HTML_ENTITIES, "htmlEntities") \
+    X(STATS, "stats") \
+    X(INPUT_BYTES, "inputBytes") \
+    X(PARSE_NS, "parseNs") \
+    X(EXTRACT_NS, "extractNs") \
+    X(BUILD_NS, "buildNs") \
+    X(NODES, "nodes") \
+    X(POOL_BYTES, "poolBytes") \
+    X(COALESCED, "coalesced") \
+    X(BINARY, "binary")
+
+#define FEED_KEY_ENUM(id, name) KEY_##id,
+#define FEED_KEY_NAME(id, name) name,
+
+enum Key {
+    FEED_KEYS(FEED_KEY_ENUM)
+    KEY_COUNT
+};
+
+static const char *KEY_NAMES[KEY_COUNT] = {
+    FEED_KEYS(FEED_KEY_NAME)
+};
+
+// Shapes of the objects created from templates
+// when the stableShape option is used. All
+// properties exist in the template in the same
+// order as set by the build functions. Missing
+// values are left undefined.
+
+enum Shape {
+    SHAPE_RSS_ITEM,
+    SHAPE_ATOM_ITEM,
+    SHAPE_LINK,
+    SHAPE_ENCLOSURE,
+    SHAPE_COUNT
+};
+
+static const Key RSS_ITEM_KEYS[] = {
+    KEY_CATEGORIES, KEY_ID, KEY_LINK, KEY_DATE, KEY_DATE_RAW, KEY_TITLE, KEY_AUTHOR,
+    KEY_ENCLOSURE, KEY_DESCRIPTION, KEY_CONTENT, KEY_EXTENSIONS
+};
+
+static const Key ATOM_ITEM_KEYS[] = {
+    KEY_ID, KEY_LINKS, KEY_TITLE, KEY_DATE, KEY_DATE_RAW, KEY_AUTHOR, KEY_AUTHOR_URI,
+    KEY_AUTHOR_EMAIL, KEY_SUMMARY, KEY_CONTENT, KEY_EXTENSIONS, KEY_LINK
+};
+
+static const Key LINK_KEYS[] = {
+    KEY_REL, KEY_HREF, KEY_TYPE, KEY_HREFLANG, KEY_TITLE, KEY_LENGTH, KEY_TEXT
+};
+
+static const Key ENCLOSURE_KEYS[] = {
+    KEY_LENGTH, KEY_TYPE, KEY_URL
+};
+
+// Input buffer shared with the external strings.
+// Reference counted so that the external strings
+// pointing into it keep it alive. The buffer is
+// reported to V8 as external memory once an external
+// string uses it. Referenced and released on the main
+// thread only.
+
+class SharedInput : public Input {
+public:
+    SharedInput() : refs(1), accounted(0) {}
+
+    // Copies the input. Buffers and typed arrays are
+    // converted from their encoding, strings are converted
+    // into UTF-8. The copy is parsed in-situ. An async
+    // input is parsed after the call returns, so its
+    // source is kept for the lenient mode.
+    void assign(const Local<Value> &xml, const ParseOptions &options, bool async) {
+        compression = COMPRESSION_NONE;
+        value.Clear();
+#if NODE_MAJOR_VERSION >= 14
+        backing.reset();
+#endif
+        if (xml->IsArrayBufferView()) {
+            Nan::TypedArrayContents<char> bytes(xml);
+            assignBytes(*bytes, bytes.length(), options.charset, options.compression);
+            if (async) {
+                keepBuffer(xml.As<ArrayBufferView>(), options.lenient);
             }
-            // Allocate the buffer + space for nul character.
-            char* buffer = (char *) malloc(neededSpace + 1);
-            // Set nul at end.
-            buffer[neededSpace] = '\0';
-            sibling = textNode;
-            // Offset into buffer.
-            size_t offset = 0;
-            // Copy to buffer.
-            while (sibling) {
-                char *value = sibling->value();
-                size_t length = strlen(value);
-                memcpy(buffer + offset, value, length);
-                offset += length;
-                sibling = sibling->next_sibling();
+        } else {
+            decode(xml);
+            if (!async) {
+                value = xml;
+            } else if (options.lenient) {
+                copySource();
+            } else {
+                clearSource();
             }
-            deallocate.push_back(buffer);
-            return buffer;
+        }
+    }
+
+    // Decodes the string again on the main thread.
+    // Other inputs are derived from their source.
+    bool restore(std::string &error) {
+        if (value.IsEmpty()) {
+            return Input::restore(error);
+        }
+        decode(value);
+        return true;
+    }
+
+    void clearSource() {
+        value.Clear();
+        Input::clearSource();
+    }
+
+    // Whether external strings use the buffer.
+    bool shared() const {
+        return refs > 1;
+    }
+
+    void ref() {
+        refs++;
+    }
+
+    void unref() {
+        if (--refs == 0) {
+            delete this;
+        }
+    }
+
+    // Reports the buffer to V8.
+    void account() {
+        if (accounted == 0) {
+            accounted = capacity();
+            Nan::AdjustExternalMemory(static_cast<int64_t>(accounted));
+        }
+    }
+
+private:
+    ~SharedInput() {
+        if (accounted > 0) {
+            Nan::AdjustExternalMemory(-static_cast<int64_t>(accounted));
+        }
+    }
+
+    // Converts a string or another value into UTF-8.
+    void decode(const Local<Value> &xml) {
+        if (xml->IsString()) {
+            size_t size = Nan::DecodeBytes(xml, Nan::UTF8);
+            Nan::DecodeWrite(resize(size), size, xml, Nan::UTF8);
         } else {
-            return textNode->value();
+            Nan::Utf8String utf8(xml);
+            memcpy(resize(utf8.length()), *utf8, utf8.length());
         }
-    } else {
-        return EMPTY_C_STRING;
     }
+
+    // Keeps the memory of the buffer as the source
+    // in the lenient mode. The buffer must not be
+    // changed until the parse is done. Resizable
+    // buffers are copied, like all buffers on Node
+    // versions without backing stores.
+    void keepBuffer(const Local<ArrayBufferView> &view, bool lenient) {
+        if (!lenient) {
+            clearSource();
+            return;
+        }
+#if NODE_MAJOR_VERSION >= 14
+        backing = view->Buffer()->GetBackingStore();
+#if NODE_MAJOR_VERSION >= 20
+        if (backing->IsResizableByUserJavaScript()) {
+            backing.reset();
+            copySource();
+        }
+#endif
+#else
+        copySource();
+#endif
+    }
+
+    int refs;
+    // Bytes reported to V8.
+    size_t accounted;
+    // Source of a synchronous parse of a string.
+    // Only valid during the call.
+    Local<Value> value;
+#if NODE_MAJOR_VERSION >= 14
+    // Keeps the memory of an async buffer source.
+    std::shared_ptr<BackingStore> backing;
+#endif
+
+    SharedInput(const SharedInput&);
+    SharedInput &operator=(const SharedInput&);
+};
+
+// External one-byte string pointing into the input.
+// Used for ASCII values.
+
+class ExternalInputString : public String::ExternalOneByteStringResource {
+public:
+    ExternalInputString(SharedInput *input, const Text &text)
+        : input(input), text(text) {
+        input->ref();
+        input->account();
+    }
+
+    ~ExternalInputString() {
+        input->unref();
+    }
+
+    const char *data() const {
+        return text.data;
+    }
+
+    size_t length() const {
+        return text.length;
+    }
+
+private:
+    SharedInput *input;
+    Text text;
+};
+
+// External two-byte string with the value decoded
+// from UTF-8. Used for non-ASCII values.
+
+class ExternalUtf16String : public String::ExternalStringResource {
+public:
+    // Returns 0 when the buffer cannot be allocated.
+    static ExternalUtf16String *create(const Text &text) {
+        uint16_t *buffer = static_cast<uint16_t*>(malloc(text.length * sizeof(uint16_t)));
+        if (!buffer) {
+            return 0;
+        }
+        return new ExternalUtf16String(text, buffer);
+    }
+
+    ~ExternalUtf16String() {
+        Nan::AdjustExternalMemory(-static_cast<int64_t>(allocated));
+        free(buffer);
+    }
+
+    const uint16_t *data() const {
+        return buffer;
+    }
+
+    size_t length() const {
+        return size;
+    }
+
+    // Decodes UTF-8 into UTF-16. The output has at
+    // most as many units as the input has bytes.
+    // Each maximal invalid subpart becomes one U+FFFD
+    // like in V8 and Buffer.toString.
+    static size_t decodeUtf8(const Text &text, uint16_t *out) {
+        const unsigned char *in = reinterpret_cast<const unsigned char*>(text.data);
+        const unsigned char *end = in + text.length;
+        size_t count = 0;
+        while (in < end) {
+            unsigned int c = *in++;
+            unsigned int code;
+            int extra;
+            // Range of the second byte. Excludes overlong
+            // forms, surrogates and values above U+10FFFF.
+            unsigned char low = 0x80;
+            unsigned char high = 0xBF;
+            if (c < 0x80) {
+                out[count++] = static_cast<uint16_t>(c);
+                continue;
+            } else if (c >= 0xC2 && c < 0xE0) {
+                code = c & 0x1F; extra = 1;
+            } else if (c >= 0xE0 && c < 0xF0) {
+                code = c & 0x0F; extra = 2;
+                if (c == 0xE0) {
+                    low = 0xA0;
+                } else if (c == 0xED) {
+                    high = 0x9F;
+                }
+            } else if (c >= 0xF0 && c < 0xF5) {
+                code = c & 0x07; extra = 3;
+                if (c == 0xF0) {
+                    low = 0x90;
+                } else if (c == 0xF4) {
+                    high = 0x8F;
+                }
+            } else {
+                out[count++] = 0xFFFD;
+                continue;
+            }
+            // Consumes only the bytes that can continue
+            // the sequence.
+            int i = 0;
+            for (; i < extra && in < end && *in >= low && *in <= high; i++) {
+                code = (code << 6) | (*in++ & 0x3F);
+                low = 0x80;
+                high = 0xBF;
+            }
+            if (i < extra) {
+                out[count++] = 0xFFFD;
+            } else if (code >= 0x10000) {
+                code -= 0x10000;
+                out[count++] = static_cast<uint16_t>(0xD800 + (code >> 10));
+                out[count++] = static_cast<uint16_t>(0xDC00 + (code & 0x3FF));
+            } else {
+                out[count++] = static_cast<uint16_t>(code);
+            }
+        }
+        return count;
+    }
+
+private:
+    ExternalUtf16String(const Text &text, uint16_t *buffer)
+        : allocated(text.length * sizeof(uint16_t)), buffer(buffer) {
+        size = decodeUtf8(text, buffer);
+        Nan::AdjustExternalMemory(static_cast<int64_t>(allocated));
+    }
+
+    size_t allocated;
+    uint16_t *buffer;
+    size_t size;
+};
+
+// Checks whether the value is ASCII only.
+
+bool isAscii(const Text &text) {
+    return asciiPrefix(text.data, text.length) == text.length;
 }
 
-// Same as readTextNode(xml_node<char>, std::vector<char*>) but
-// takes an optional child node name.
+// Data kept per isolate. Created once at module
+// initialization and passed to the functions as
+// their data. Keeps the property names as
+// internalized strings so that they are not
+// allocated again for every object.
 
-char const *readTextNode(xml_node<char> *rootNode, const char* name, std::vector<char*> &deallocate) {
-    xml_node<char> *node = rootNode->first_node(name);
-    if (node) {
-        return readTextNode(node, deallocate);
-    } else {
-        return 0;
+class IsolateData {
+public:
+    IsolateData() : input(0) {
+        Isolate *isolate = Isolate::GetCurrent();
+        for (int i = 0; i < KEY_COUNT; i++) {
+            keys[i].Reset(String::NewFromUtf8(isolate, KEY_NAMES[i],
+                NewStringType::kInternalized).ToLocalChecked());
+        }
+        createTemplate(SHAPE_RSS_ITEM, RSS_ITEM_KEYS, sizeof(RSS_ITEM_KEYS) / sizeof(Key));
+        createTemplate(SHAPE_ATOM_ITEM, ATOM_ITEM_KEYS, sizeof(ATOM_ITEM_KEYS) / sizeof(Key));
+        createTemplate(SHAPE_LINK, LINK_KEYS, sizeof(LINK_KEYS) / sizeof(Key));
+        createTemplate(SHAPE_ENCLOSURE, ENCLOSURE_KEYS, sizeof(ENCLOSURE_KEYS) / sizeof(Key));
+        Local<Object> date = Nan::To<Object>(Nan::Get(Nan::GetCurrentContext()->Global(),
+            Nan::New<String>("Date").ToLocalChecked()).ToLocalChecked()).ToLocalChecked();
+        dateObject.Reset(date);
+        dateParse.Reset(Nan::Get(date, Nan::New<String>("parse").ToLocalChecked())
+            .ToLocalChecked().As<Function>());
+        Local<ObjectTemplate> wrapper = Nan::New<ObjectTemplate>();
+        wrapper->SetInternalFieldCount(1);
+        wrapperTemplate.Reset(wrapper);
+    }
+
+    ~IsolateData() {
+        for (int i = 0; i < KEY_COUNT; i++) {
+            keys[i].Reset();
+        }
+        for (int i = 0; i < SHAPE_COUNT; i++) {
+            templates[i].Reset();
+        }
+        dateObject.Reset();
+        dateParse.Reset();
+        wrapperTemplate.Reset();
+    }
+
+    Local<String> key(Key key) const {
+        return Nan::New(keys[key]);
+    }
+
+    // Creates a new object. With the stableShape
+    // option the object is created from the template.
+    Local<Object> newObject(const ParseOptions &options, Shape shape) const {
+        if (options.stableShape) {
+            return Nan::NewInstance(Nan::New(templates[shape])).ToLocalChecked();
+        } else {
+            return Nan::New<Object>();
+        }
+    }
+
+    // Creates an object for wrapping
+    // a native object.
+    Local<Object> newWrapper() const {
+        return Nan::NewInstance(Nan::New(wrapperTemplate)).ToLocalChecked();
+    }
+
+    // Parses the date with JS Date.parse. Used for
+    // dates that cannot be parsed natively.
+    double parseDate(const Local<String> &date) const {
+        Local<Value> argv[] = { date };
+        Local<Value> time;
+        if (!Nan::Call(Nan::New(dateParse), Nan::New(dateObject), 1, argv).ToLocal(&time)) {
+            return NAN;
+        }
+        return Nan::To<double>(time).FromMaybe(NAN);
+    }
+
+private:
+    void createTemplate(Shape shape, const Key *shapeKeys, size_t count) {
+        Local<ObjectTemplate> objectTemplate = Nan::New<ObjectTemplate>();
+        for (size_t i = 0; i < count; i++) {
+            Nan::SetTemplate(objectTemplate, key(shapeKeys[i]), Nan::Undefined());
+        }
+        templates[shape].Reset(objectTemplate);
+    }
+
+    Nan::Persistent<String> keys[KEY_COUNT];
+    Nan::Persistent<ObjectTemplate> templates[SHAPE_COUNT];
+    Nan::Persistent<Object> dateObject;
+    Nan::Persistent<Function> dateParse;
+    Nan::Persistent<ObjectTemplate> wrapperTemplate;
+
+public:
+    // Input of the feed being built. Large values
+    // can be external strings pointing into it.
+    // Set for the duration of the build with InputScope.
+    mutable SharedInput *input;
+};
+
+// Sets the input of the build for
+// the lifetime of the scope.
+
+class InputScope {
+public:
+    InputScope(const IsolateData &data, SharedInput *input) : data(data), previous(data.input) {
+        data.input = input;
+    }
+
+    ~InputScope() {
+        data.input = previous;
     }
+
+private:
+    const IsolateData &data;
+    SharedInput *previous;
+};
+
+// Helper to get the isolate data from
+// the function data.
+
+IsolateData *getIsolateData(const Nan::FunctionCallbackInfo<Value> &info) {
+    return static_cast<IsolateData*>(info.Data().As<External>()->Value());
 }
 
-// Frees all manually allocated strings.
+// Default minimum length of external strings.
 
-void deallocateStrings(const std::vector<char*> &deallocate) {
-    for (std::vector<char*>::const_iterator it = deallocate.begin(); it != deallocate.end(); ++it) {
-        free(*it);
+static const size_t DEFAULT_EXTERNAL_THRESHOLD = 64 * 1024;
+
+// Helper to read a boolean option.
+
+bool readBoolOption(const IsolateData &data, const Local<Object> &object, Key key, bool defaultValue) {
+    Local<Value> value = Nan::Get(object, data.key(key)).ToLocalChecked();
+    if (value->IsUndefined()) {
+        return defaultValue;
     }
+    return Nan::To<bool>(value).FromMaybe(defaultValue);
 }
 
-// Checks whether the node has only
-// text, CDATA or comment children.
+// Reads the fields option into the mask.
+// Returns false on an invalid value.
 
-bool textOnly(xml_node<char> *node) {
-    xml_node<char> *child = node->first_node();
-    while (child) {
-        if (child->type() != node_data &&
-            child->type() != node_cdata &&
-            child->type() != node_comment) {
+bool readFieldsOption(const IsolateData &data, const Local<Object> &object, unsigned int *fields) {
+    Local<Value> value = Nan::Get(object, data.key(KEY_FIELDS)).ToLocalChecked();
+    if (value->IsUndefined()) {
+        return true;
+    }
+    if (!value->IsArray()) {
+        Nan::ThrowTypeError("The fields option must be an array");
+        return false;
+    }
+    Local<Array> array = value.As<Array>();
+    *fields = 0;
+    for (uint32_t i = 0; i < array->Length(); i++) {
+        Nan::Utf8String name(Nan::Get(array, i).ToLocalChecked());
+        unsigned int field = findField(*name);
+        if (field == 0) {
+            std::string error = "Unknown field: ";
+            error += *name;
+            Nan::ThrowTypeError(error.c_str());
             return false;
         }
-        child = child->next_sibling();
+        *fields |= field;
     }
     return true;
 }
 
-// Checks whether the given node is an
-// extension node.
-
-bool isExtension(xml_node<char> *node) {
-    // Check that name contains
-    // the namespace separator.
-    return strchr(node->name(), ':') && textOnly(node);
-}
-
-// Checks whether the given XML node
-// has extensions.
-
-bool hasExtensions(xml_node<char> *node) {
-    xml_node<char> *extensionNode = node->first_node();
-    while (extensionNode) {
-        if (isExtension(extensionNode)) {
-            return true;
-        }
-        extensionNode = extensionNode->next_sibling();
-    }
-    return false;
-}
-
-// Extracts extensions from the given node.
-// Assumes that extensions use namespaces.
-
-void doExtractExtensions(xml_node<char> *node, const Local<Object> &base, std::vector<char*> &deallocate) {
-    if (hasExtensions(node)) {
-        // Only create data structures if there are
-        // any extensions.
-        Local<Array> extensions = Nan::New<Array>();
-        int i = 0;
-        Nan::Set(base, Nan::New<String>("extensions").ToLocalChecked(), extensions);
-        xml_node<char> *extensionNode = node->first_node();
-        while (extensionNode) {
-            if (isExtension(extensionNode)) {
-                char const *name = extensionNode->name();
-                char const *extensionValue = readTextNode(extensionNode, deallocate);
-                Local<Object> extension = Nan::New<Object>();
-                Nan::Set(extension, Nan::New("name").ToLocalChecked(),
-                    Nan::New<String>(name).ToLocalChecked());
-                Nan::Set(extension, Nan::New<String>("value").ToLocalChecked(),
-                    Nan::New<String>(extensionValue).ToLocalChecked());
-                xml_attribute<char> *attributeNode = extensionNode->first_attribute();
-                if (attributeNode) {
-                    Local<Object> attributes = Nan::New<Object>();
-                    while (attributeNode) {
-                        Nan::Set(attributes, Nan::New<String>(attributeNode->name()).ToLocalChecked(),
-                            Nan::New<String>(attributeNode->value()).ToLocalChecked());
-                        attributeNode = attributeNode->next_attribute();
-                    }
-                    Nan::Set(extension, Nan::New<String>("attributes").ToLocalChecked(), attributes);
-                }
-                Nan::Set(extensions, i, extension);
-                i++;
+// Reads the charset option. Returns false
+// on an unknown charset.
+
+bool readCharsetOption(const IsolateData &data, const Local<Object> &object, Charset *charset) {
+    Local<Value> value = Nan::Get(object, data.key(KEY_CHARSET)).ToLocalChecked();
+    if (value->IsUndefined() || value->IsNull()) {
+        return true;
+    }
+    Nan::Utf8String name(value);
+    *charset = findCharset(*name, name.length());
+    if (*charset == CHARSET_UNKNOWN) {
+        std::string error = "Unknown charset: ";
+        error += *name;
+        Nan::ThrowTypeError(error.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Reads the compression option. Returns false
+// on an unknown compression.
+
+bool readCompressionOption(const IsolateData &data, const Local<Object> &object, Compression *compression) {
+    Local<Value> value = Nan::Get(object, data.key(KEY_COMPRESSION)).ToLocalChecked();
+    if (value->IsUndefined() || value->IsNull()) {
+        return true;
+    }
+    if (value->IsBoolean()) {
+        *compression = Nan::To<bool>(value).FromJust() ? COMPRESSION_AUTO : COMPRESSION_NONE;
+        return true;
+    }
+    Nan::Utf8String name(value);
+    if (strcmp(*name, "gzip") == 0 || strcmp(*name, "x-gzip") == 0) {
+        *compression = COMPRESSION_GZIP;
+    } else if (strcmp(*name, "deflate") == 0) {
+        *compression = COMPRESSION_DEFLATE;
+    } else if (strcmp(*name, "deflate-raw") == 0) {
+        *compression = COMPRESSION_DEFLATE_RAW;
+    } else if (strcmp(*name, "identity") == 0 || strcmp(*name, "none") == 0) {
+        *compression = COMPRESSION_NONE;
+    } else {
+        std::string error = "Unknown compression: ";
+        error += *name;
+        Nan::ThrowTypeError(error.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Reads the externalStrings option. A number
+// sets the minimum length, true uses the default.
+
+void readExternalOption(const IsolateData &data, const Local<Object> &object, size_t *threshold) {
+    Local<Value> value = Nan::Get(object, data.key(KEY_EXTERNAL_STRINGS)).ToLocalChecked();
+    if (value->IsNumber()) {
+        *threshold = Nan::To<uint32_t>(value).FromMaybe(0);
+    } else if (!value->IsUndefined()) {
+        *threshold = Nan::To<bool>(value).FromMaybe(false) ? DEFAULT_EXTERNAL_THRESHOLD : 0;
+    }
+}
+
+// Reads options from the JS options object.
+// Missing options keep their defaults. Returns
+// false and throws on invalid options.
+
+bool readOptions(const IsolateData &data, const Local<Value> &value, ParseOptions &options) {
+    if (!value->IsObject()) {
+        return true;
+    }
+    Local<Object> object = value.As<Object>();
+    options.extractContent = readBoolOption(data, object, KEY_CONTENT, options.extractContent);
+    options.extractExtensions = readBoolOption(data, object, KEY_EXTENSIONS, options.extractExtensions);
+    options.stableShape = readBoolOption(data, object, KEY_STABLE_SHAPE, options.stableShape);
+    options.timestamps = readBoolOption(data, object, KEY_TIMESTAMPS, options.timestamps);
+    options.rawDates = readBoolOption(data, object, KEY_RAW_DATES, options.rawDates);
+    options.atomLinks = readBoolOption(data, object, KEY_LINKS, options.atomLinks);
+    readExternalOption(data, object, &options.externalThreshold);
+    options.lazy = readBoolOption(data, object, KEY_LAZY, options.lazy);
+    options.lenient = readBoolOption(data, object, KEY_LENIENT, options.lenient);
+    options.htmlEntities = readBoolOption(data, object, KEY_HTML_ENTITIES, options.htmlEntities);
+    options.stats = readBoolOption(data, object, KEY_STATS, options.stats);
+    options.binary = readBoolOption(data, object, KEY_BINARY, options.binary);
+    return readCharsetOption(data, object, &options.charset) &&
+        readCompressionOption(data, object, &options.compression) &&
+        readFieldsOption(data, object, &options.fields);
+}
+
+// Creates the JS string with the known length.
+// ASCII values are created as one-byte strings.
+// Others are decoded by V8, which replaces each
+// maximal invalid subpart with U+FFFD like
+// Buffer.toString does.
+
+Local<String> newString(const Text &value) {
+    if (asciiPrefix(value.data, value.length) == value.length) {
+        return String::NewFromOneByte(Isolate::GetCurrent(), reinterpret_cast<const uint8_t*>(value.data),
+            NewStringType::kNormal, static_cast<int>(value.length)).ToLocalChecked();
+    }
+    return Nan::New<String>(value.data, static_cast<int>(value.length)).ToLocalChecked();
+}
+
+// Helper to set a string property.
+// Skips missing (0) values.
+
+void setString(const Local<Object> &target, const Local<String> &key, const Text &value) {
+    if (!value.missing()) {
+        Nan::Set(target, key, newString(value));
+    }
+}
+
+// Creates the content, description or summary
+// string. Large values are external strings
+// with the externalStrings option.
+
+Local<String> newLargeString(const IsolateData &data, const ParseOptions &options, const Text &value) {
+    if (options.externalThreshold == 0 || value.length < options.externalThreshold || !data.input) {
+        return newString(value);
+    } else if (isAscii(value)) {
+        return Nan::New<String>(new ExternalInputString(data.input, value)).ToLocalChecked();
+    }
+    // Falls back to a V8 string when the
+    // external buffer cannot be allocated.
+    ExternalUtf16String *external = ExternalUtf16String::create(value);
+    if (!external) {
+        return newString(value);
+    }
+    return Nan::New<String>(external).ToLocalChecked();
+}
+
+// Creates the extensions array.
+
+Local<Array> newExtensions(const IsolateData &data, const std::vector<FeedExtension> &extensions) {
+    Local<Array> array = Nan::New<Array>(extensions.size());
+    for (size_t i = 0; i < extensions.size(); i++) {
+        const FeedExtension &extension = extensions[i];
+        Local<Object> object = Nan::New<Object>();
+        setString(object, data.key(KEY_NAME), extension.name);
+        setString(object, data.key(KEY_VALUE), extension.value);
+        if (!extension.attributes.empty()) {
+            Local<Object> attributes = Nan::New<Object>();
+            for (size_t j = 0; j < extension.attributes.size(); j++) {
+                setString(attributes, newString(extension.attributes[j].first),
+                    extension.attributes[j].second);
             }
-            extensionNode = extensionNode->next_sibling();
+            Nan::Set(object, data.key(KEY_ATTRIBUTES), attributes);
         }
+        Nan::Set(array, i, object);
     }
+    return array;
 }
 
-// Helper to populate object properties from XML
-// node attributes.
+// Builds the extensions array when there
+// are any extensions.
 
-void populateFromAttributes(xml_node<char> *node, const Local<Object> &target) {
-    xml_attribute<char> *attributeNode = node->first_attribute();
-    while (attributeNode) {
-        Nan::Set(target, Nan::New<String>(attributeNode->name()).ToLocalChecked(),
-            Nan::New<String>(attributeNode->value()).ToLocalChecked());
-        attributeNode = attributeNode->next_attribute();
+void buildExtensions(const IsolateData &data, const std::vector<FeedExtension> &extensions, const Local<Object> &base) {
+    if (!extensions.empty()) {
+        Nan::Set(base, data.key(KEY_EXTENSIONS), newExtensions(data, extensions));
     }
 }
 
-// Helper to parse string into an integer.
-// From: https://stackoverflow.com/questions/14176123/correct-usage-of-strtol
-// Returns true when conversion was successful.
+// Content values and extensions of an item built
+// on the first access with the lazy option. The
+// item object gets accessors that keep the built
+// or assigned values on the wrapper, so the object
+// keeps its fast properties and key order. Keeps
+// the input alive until all the values are built.
+
+class LazyItem : public Nan::ObjectWrap {
+public:
+    // Returns 0 when the values are built
+    // right away.
+    static LazyItem *create(const IsolateData &data, const ParseOptions &options, const Item &item) {
+        if (!options.lazy || !data.input) {
+            return 0;
+        }
+        if (item.summary.missing() && item.description.missing() && item.content.missing() && item.extensions.empty()) {
+            return 0;
+        }
+        LazyItem *lazy = new LazyItem(data, options, item);
+        lazy->Wrap(data.newWrapper());
+        return lazy;
+    }
+
+    // Adds the accessor for the key.
+    void define(const Local<Object> &itemObject, Key key) {
+        Nan::SetAccessor(itemObject, data.key(key), Get, Set, handle());
+        pending++;
+    }
+
+private:
+    LazyItem(const IsolateData &data, const ParseOptions &options, const Item &item)
+        : data(data), options(options), input(data.input), pending(0), summary(item.summary),
+        description(item.description), content(item.content), extensions(item.extensions) {
+        input->ref();
+        input->account();
+    }
 
-bool parseLong(const char *str, long *val) {
-    char *temp;
-    bool rc = true;
-    errno = 0;
-    *val = strtol(str, &temp, 0);
-    if (temp == str || *temp != '\0' ||
-        ((*val == LONG_MIN || *val == LONG_MAX) && errno == ERANGE)) {
-            rc = false;
+    ~LazyItem() {
+        if (input) {
+            input->unref();
+        }
+    }
+
+    Local<Value> build(const Local<String> &property) const {
+        InputScope scope(data, input);
+        if (property->StrictEquals(data.key(KEY_EXTENSIONS))) {
+            return newExtensions(data, extensions);
+        } else if (property->StrictEquals(data.key(KEY_SUMMARY))) {
+            return newLargeString(data, options, summary);
+        } else if (property->StrictEquals(data.key(KEY_DESCRIPTION))) {
+            return newLargeString(data, options, description);
+        } else {
+            return newLargeString(data, options, content);
+        }
+    }
+
+    // Keeps the value on the wrapper. Releases the
+    // input once all the values are built or assigned.
+    void store(const Local<String> &property, const Local<Value> &value) {
+        Local<Object> wrapper = handle();
+        if (!Nan::HasOwnProperty(wrapper, property).FromJust() && --pending == 0) {
+            input->unref();
+            input = 0;
+        }
+        Nan::Set(wrapper, property, value);
+    }
+
+    // Builds the value on the first access.
+    static NAN_GETTER(Get) {
+        LazyItem *lazy = Nan::ObjectWrap::Unwrap<LazyItem>(info.Data().As<Object>());
+        Local<Object> wrapper = lazy->handle();
+        if (Nan::HasOwnProperty(wrapper, property).FromJust()) {
+            info.GetReturnValue().Set(Nan::Get(wrapper, property).ToLocalChecked());
+            return;
         }
-    return rc;
+        Local<Value> value = lazy->build(property);
+        lazy->store(property, value);
+        info.GetReturnValue().Set(value);
+    }
+
+    static NAN_SETTER(Set) {
+        Nan::ObjectWrap::Unwrap<LazyItem>(info.Data().As<Object>())->store(property, value);
+    }
+
+    const IsolateData &data;
+    ParseOptions options;
+    SharedInput *input;
+    // Accessors whose values are not built yet.
+    size_t pending;
+    Text summary;
+    Text description;
+    Text content;
+    std::vector<FeedExtension> extensions;
+};
+
+// Sets the content, description or summary
+// property. Adds the accessor with the lazy option.
+
+void setContent(const IsolateData &data, const ParseOptions &options, LazyItem *lazy,
+    const Local<Object> &target, Key key, const Text &value) {
+    if (value.missing()) {
+        return;
+    }
+    if (lazy) {
+        lazy->define(target, key);
+    } else {
+        Nan::Set(target, data.key(key), newLargeString(data, options, value));
+    }
 }
 
-// Extracts the enclosure element from the given node.
+// Sets the item extensions property. Adds the
+// accessor with the lazy option.
 
-void doExtractEnclosure(xml_node<char> *node, const Local<Object> &item) {
-    xml_node<char> *enclosureNode = node->first_node("enclosure");
-    if (!enclosureNode) {
+void setItemExtensions(const IsolateData &data, LazyItem *lazy, const Local<Object> &target,
+    const std::vector<FeedExtension> &extensions) {
+    if (extensions.empty()) {
         return;
     }
-    Local<Object> enclosure = Nan::New<Object>();
-    xml_attribute<char> *lengthAttr = enclosureNode->first_attribute("length");
-    if (lengthAttr) {
-        long length = 0;
-        if (parseLong(lengthAttr->value(), &length)) {
-            Nan::Set(enclosure, Nan::New<String>("length").ToLocalChecked(), Nan::New<Number>(length));
+    if (lazy) {
+        lazy->define(target, KEY_EXTENSIONS);
+    } else {
+        Nan::Set(target, data.key(KEY_EXTENSIONS), newExtensions(data, extensions));
+    }
+}
+
+// Builds the item date property. The date is a Date
+// object or a timestamp with the timestamps option.
+// Dates not parsed natively are parsed with Date.parse.
+
+void buildDate(const IsolateData &data, const ParseOptions &options, const Item &item, const Local<Object> &target) {
+    if (item.date.missing()) {
+        return;
+    }
+    double time = item.time;
+    Local<String> raw;
+    if (!item.dateParsed || options.rawDates) {
+        raw = newString(item.date);
+    }
+    if (!item.dateParsed) {
+        time = data.parseDate(raw);
+    }
+    if (options.timestamps) {
+        Nan::Set(target, data.key(KEY_DATE), Nan::New<Number>(time));
+    } else {
+        Nan::Set(target, data.key(KEY_DATE), Nan::New<Date>(time).ToLocalChecked());
+    }
+    if (options.rawDates) {
+        Nan::Set(target, data.key(KEY_DATE_RAW), raw);
+    }
+}
+
+// Builds the author properties.
+
+void buildAuthor(const IsolateData &data, const Author &author, const Local<Object> &base) {
+    setString(base, data.key(KEY_AUTHOR), author.name);
+    setString(base, data.key(KEY_AUTHOR_URI), author.uri);
+    setString(base, data.key(KEY_AUTHOR_EMAIL), author.email);
+}
+
+// Builds the JS object for the Atom entry.
+
+Local<Object> buildAtomItem(const IsolateData &data, const Item &item, const ParseOptions &options) {
+    Local<Object> itemObject = data.newObject(options, SHAPE_ATOM_ITEM);
+    LazyItem *lazy = LazyItem::create(data, options, item);
+    setString(itemObject, data.key(KEY_ID), item.id);
+    if (options.itemFields() & FIELD_LINKS) {
+        Local<Array> links = Nan::New<Array>(item.links.size());
+        for (size_t j = 0; j < item.links.size(); j++) {
+            const Link &link = item.links[j];
+            Local<Object> linkObject = data.newObject(options, SHAPE_LINK);
+            setString(linkObject, data.key(KEY_REL), link.rel);
+            setString(linkObject, data.key(KEY_HREF), link.href);
+            setString(linkObject, data.key(KEY_TYPE), link.type);
+            setString(linkObject, data.key(KEY_HREFLANG), link.hreflang);
+            setString(linkObject, data.key(KEY_TITLE), link.title);
+            setString(linkObject, data.key(KEY_LENGTH), link.length);
+            setString(linkObject, data.key(KEY_TEXT), link.text);
+            Nan::Set(links, j, linkObject);
+        }
+        Nan::Set(itemObject, data.key(KEY_LINKS), links);
+    }
+    setString(itemObject, data.key(KEY_TITLE), item.title);
+    buildDate(data, options, item, itemObject);
+    buildAuthor(data, item.author, itemObject);
+    setContent(data, options, lazy, itemObject, KEY_SUMMARY, item.summary);
+    setContent(data, options, lazy, itemObject, KEY_CONTENT, item.content);
+    setItemExtensions(data, lazy, itemObject, item.extensions);
+    setString(itemObject, data.key(KEY_LINK), item.link);
+    return itemObject;
+}
+
+// Builds the JS object for the Atom feed.
+
+void buildAtomFeed(const IsolateData &data, const Feed &feed, const ParseOptions &options, const Local<Object> &object) {
+    Nan::Set(object, data.key(KEY_TYPE), data.key(KEY_ATOM));
+    setString(object, data.key(KEY_TITLE), feed.title);
+    setString(object, data.key(KEY_ID), feed.id);
+    setString(object, data.key(KEY_LINK), feed.link);
+    buildAuthor(data, feed.author, object);
+    buildExtensions(data, feed.extensions, object);
+    Local<Array> items = Nan::New<Array>(feed.items.size());
+    for (size_t i = 0; i < feed.items.size(); i++) {
+        Nan::Set(items, i, buildAtomItem(data, feed.items[i], options));
+    }
+    Nan::Set(object, data.key(KEY_ITEMS), items);
+}
+
+// Builds the JS object for the RSS item.
+
+Local<Object> buildRssItem(const IsolateData &data, const Item &item, const ParseOptions &options) {
+    Local<Object> itemObject = data.newObject(options, SHAPE_RSS_ITEM);
+    LazyItem *lazy = LazyItem::create(data, options, item);
+    if (!item.categories.empty()) {
+        Local<Array> categories = Nan::New<Array>(item.categories.size());
+        for (size_t j = 0; j < item.categories.size(); j++) {
+            Local<Object> categoryObject = Nan::New<Object>();
+            setString(categoryObject, data.key(KEY_NAME), item.categories[j]);
+            Nan::Set(categories, j, categoryObject);
         }
+        Nan::Set(itemObject, data.key(KEY_CATEGORIES), categories);
     }
-    xml_attribute<char> *typeAttr = enclosureNode->first_attribute("type");
-    if (typeAttr) {
-        Nan::Set(enclosure, Nan::New<String>("type").ToLocalChecked(),
-            Nan::New<String>(typeAttr->value()).ToLocalChecked());
+    setString(itemObject, data.key(KEY_ID), item.id);
+    setString(itemObject, data.key(KEY_LINK), item.link);
+    buildDate(data, options, item, itemObject);
+    setString(itemObject, data.key(KEY_TITLE), item.title);
+    setString(itemObject, data.key(KEY_AUTHOR), item.author.name);
+    if (item.enclosure.present) {
+        const Enclosure &enclosure = item.enclosure;
+        Local<Object> enclosureObject = data.newObject(options, SHAPE_ENCLOSURE);
+        if (enclosure.hasLength) {
+            Nan::Set(enclosureObject, data.key(KEY_LENGTH), Nan::New<Number>(enclosure.length));
+        }
+        setString(enclosureObject, data.key(KEY_TYPE), enclosure.type);
+        setString(enclosureObject, data.key(KEY_URL), enclosure.url);
+        Nan::Set(itemObject, data.key(KEY_ENCLOSURE), enclosureObject);
     }
-    xml_attribute<char> *urlAttr = enclosureNode->first_attribute("url");
-    if (urlAttr) {
-        Nan::Set(enclosure, Nan::New<String>("url").ToLocalChecked(),
-            Nan::New<String>(urlAttr->value()).ToLocalChecked());
+    setContent(data, options, lazy, itemObject, KEY_DESCRIPTION, item.description);
+    setContent(data, options, lazy, itemObject, KEY_CONTENT, item.content);
+    setItemExtensions(data, lazy, itemObject, item.extensions);
+    return itemObject;
+}
+
+// Builds the JS object for the RSS feed.
+
+void buildRssFeed(const IsolateData &data, const Feed &feed, const ParseOptions &options, const Local<Object> &object) {
+    Nan::Set(object, data.key(KEY_TYPE), data.key(KEY_RSS));
+    setString(object, data.key(KEY_TITLE), feed.title);
+    setString(object, data.key(KEY_DESCRIPTION), feed.description);
+    setString(object, data.key(KEY_LINK), feed.link);
+    setString(object, data.key(KEY_AUTHOR), feed.author.name);
+    buildExtensions(data, feed.extensions, object);
+    Local<Array> items = Nan::New<Array>(feed.items.size());
+    for (size_t i = 0; i < feed.items.size(); i++) {
+        Nan::Set(items, i, buildRssItem(data, feed.items[i], options));
     }
-    Nan::Set(item, Nan::New<String>("enclosure").ToLocalChecked(), enclosure);
+    Nan::Set(object, data.key(KEY_ITEMS), items);
+}
+
+// Builds the stats object. The build time
+// is measured by the caller.
+
+Local<Object> buildStats(const IsolateData &data, const ParseStats &stats, uint64_t buildNs) {
+    Local<Object> object = Nan::New<Object>();
+    Nan::Set(object, data.key(KEY_INPUT_BYTES), Nan::New<Number>(static_cast<double>(stats.inputBytes)));
+    Nan::Set(object, data.key(KEY_PARSE_NS), Nan::New<Number>(static_cast<double>(stats.parseNs)));
+    Nan::Set(object, data.key(KEY_EXTRACT_NS), Nan::New<Number>(static_cast<double>(stats.extractNs)));
+    Nan::Set(object, data.key(KEY_BUILD_NS), Nan::New<Number>(static_cast<double>(buildNs)));
+    Nan::Set(object, data.key(KEY_NODES), Nan::New<Number>(static_cast<double>(stats.nodes)));
+    Nan::Set(object, data.key(KEY_POOL_BYTES), Nan::New<Number>(static_cast<double>(stats.poolBytes)));
+    Nan::Set(object, data.key(KEY_COALESCED), Nan::New<Number>(static_cast<double>(stats.coalesced)));
+    Nan::Set(object, data.key(KEY_ITEMS), Nan::New<Number>(static_cast<double>(stats.items)));
+    Nan::Set(object, data.key(KEY_EXTENSIONS), Nan::New<Number>(static_cast<double>(stats.extensions)));
+    return object;
 }
 
-// Helper to find the line number of error.
+// Builds the JS object for the extracted feed.
 
-std::pair<int, int> findErrorLine(const char* xml, const char* where) {
-    int i = 0;
-    int ln = 1;
-    char ch = 0;
-    int col = 1;
-    while (true) {
-        if (xml + i == where) {
-            break;
+Local<Object> buildFeed(const IsolateData &data, const Feed &feed, const ParseOptions &options) {
+    uint64_t start = options.stats ? monotonicNs() : 0;
+    Local<Object> object = Nan::New<Object>();
+    if (feed.atom) {
+        buildAtomFeed(data, feed, options, object);
+    } else {
+        buildRssFeed(data, feed, options, object);
+    }
+    if (options.lenient) {
+        Local<Array> warnings = Nan::New<Array>(feed.warnings.size());
+        for (size_t i = 0; i < feed.warnings.size(); i++) {
+            Nan::Set(warnings, i, Nan::New<String>(feed.warnings[i]).ToLocalChecked());
         }
-        ch = xml[i];
-        if (ch == '\n') {
-            ln++;
-            col = 0;
+        Nan::Set(object, data.key(KEY_WARNINGS), warnings);
+    }
+    if (options.stats) {
+        Nan::Set(object, data.key(KEY_STATS), buildStats(data, feed.stats, monotonicNs() - start));
+    }
+    return object;
+}
+
+// Writes the feed into a new ArrayBuffer
+// with the binary layout.
+
+Local<ArrayBuffer> buildBinary(const Feed &feed) {
+    BinaryWriter writer(feed);
+    Local<ArrayBuffer> buffer = ArrayBuffer::New(Isolate::GetCurrent(), writer.size());
+    Nan::TypedArrayContents<char> contents(Uint8Array::New(buffer, 0, writer.size()));
+    writer.write(*contents);
+    return buffer;
+}
+
+// Builds the feed object or the
+// binary result.
+
+Local<Value> buildResult(const IsolateData &data, const Feed &feed, const ParseOptions &options) {
+    if (options.binary) {
+        return buildBinary(feed);
+    }
+    return buildFeed(data, feed, options);
+}
+
+// Checks that the binary result can be
+// written. Its offsets are 32-bit.
+
+bool checkBinary(const Feed &feed, const ParseOptions &options, std::string &error) {
+    if (options.binary && !BinaryWriter(feed).fits()) {
+        error = "Feed is too large for the binary result.";
+        return false;
+    }
+    return true;
+}
+
+// Single parse of a feed. Owns the copy of the
+// input and the extracted feed so that the parse
+// can run on a thread that cannot access V8.
+
+class ParseJob {
+public:
+    ParseJob() : ok(false), input(new SharedInput()) {}
+
+    ~ParseJob() {
+        input->unref();
+    }
+
+    // Copies the input. Must be called on the
+    // main thread. With async the job runs
+    // after the call returns.
+    void setInput(const Local<Value> &xml, const ParseOptions &options, bool async) {
+        input->assign(xml, options, async);
+    }
+
+    // Decompresses and parses. Runs on any thread.
+    void run(const ParseOptions &options) {
+        xml_document<char> doc;
+        ok = parseInput(doc, *input, feed, options, error) && checkBinary(feed, options, error);
+    }
+
+    // Builds either the feed object or
+    // the error object.
+    Local<Value> result(const IsolateData &data, const ParseOptions &options) const {
+        if (ok) {
+            InputScope scope(data, input);
+            return buildResult(data, feed, options);
         } else {
-            col++;
+            return Nan::TypeError(error.c_str());
         }
-        i++;
     }
-    return std::pair<int, int>(ln, col);
-}
 
-// Parses the Atom feed/item author node.
+    bool ok;
+    Feed feed;
+    std::string error;
 
-void parseAtomAuthor(xml_node<char> *feedNode, const Local<Object> &base, std::vector<char*> &deallocate) {
-    xml_node<char> *authorNode = feedNode->first_node("author");
-    if (!authorNode) {
-        // No author set.
-        return;
+private:
+    SharedInput *input;
+
+    ParseJob(const ParseJob&);
+    ParseJob &operator=(const ParseJob&);
+};
+
+// Runs parsing and extraction on the libuv
+// thread pool. The JS objects are built once
+// the work is complete.
+
+class ParseWorker : public Nan::AsyncWorker {
+public:
+    ParseWorker(Nan::Callback *callback, const IsolateData *data, const Local<Value> &xml,
+        const ParseOptions &options)
+        : Nan::AsyncWorker(callback, "fast-feed:parse"), data(data), options(options) {
+        job.setInput(xml, options, true);
     }
-    char const *name = readTextNode(authorNode, "name", deallocate);
-    if (name) {
-        // Name node is set.
-        Nan::Set(base, Nan::New<String>("author").ToLocalChecked(),
-            Nan::New<String>(name).ToLocalChecked());
-        // Try to get uri and email nodes too.
-        char const *uri = readTextNode(authorNode, "uri", deallocate);
-        if (uri) {
-            Nan::Set(base, Nan::New<String>("author_uri").ToLocalChecked(),
-                Nan::New<String>(uri).ToLocalChecked());
-        }
-        char const *email = readTextNode(authorNode, "email", deallocate);
-        if (email) {
-            Nan::Set(base, Nan::New<String>("author_email").ToLocalChecked(),
-                Nan::New<String>(email).ToLocalChecked());
+
+    void Execute() {
+        job.run(options);
+        if (!job.ok) {
+            SetErrorMessage(job.error.c_str());
         }
-    } else {
-        // Whole author node is probably a text node.
-        char const *author = readTextNode(feedNode, "author", deallocate);
-        if (author) {
-            Nan::Set(base, Nan::New<String>("author").ToLocalChecked(),
-                Nan::New<String>(author).ToLocalChecked());
-        }
-    }
-}
-
-// Parses the Atom feed.
-
-void parseAtomFeed(xml_node<char> *feedNode, const Local<Object> &feed, bool extractContent, bool extractExtensions) {
-    // Vector string pointers not
-    // deallocated by RapidXML.
-    std::vector<char*> deallocate;
-    Nan::Set(feed, Nan::New<String>("type").ToLocalChecked(),
-        Nan::New<String>("atom").ToLocalChecked());
-    // Extracts the title property.
-    char const *title = readTextNode(feedNode, "title", deallocate);
-    if (title) {
-        Nan::Set(feed, Nan::New<String>("title").ToLocalChecked(),
-            Nan::New<String>(title).ToLocalChecked());
-    }
-    // Extracts the id property.
-    char const *id = readTextNode(feedNode, "id", deallocate);
-    if (id) {
-        Nan::Set(feed, Nan::New<String>("id").ToLocalChecked(),
-            Nan::New<String>(id).ToLocalChecked());
-    }
-    // Extracts the link property.
-    xml_node<char> *linkNode = feedNode->first_node("link");
-    if (linkNode) {
-        xml_attribute<char> *hrefAttr = linkNode->first_attribute("href");
-        if (hrefAttr) {
-            Nan::Set(feed, Nan::New<String>("link").ToLocalChecked(),
-                Nan::New<String>(hrefAttr->value()).ToLocalChecked());
-        }
-    }
-    // Extracts the author property.
-    parseAtomAuthor(feedNode, feed, deallocate);
-    // Extracts extensions when configured to.
-    if (extractExtensions) {
-        doExtractExtensions(feedNode, feed, deallocate);
-    }
-    // Extract all channel items.
-    Local<Array> items = Nan::New<Array>();
-    xml_node<char> *itemNode = feedNode->first_node("entry");
-    int i = 0;
-    while (itemNode) {
-        Local<Object> item = Nan::New<Object>();
-        // Extracts the id property.
-        char const *id = readTextNode(itemNode, "id", deallocate);
-        if (id) {
-            Nan::Set(item, Nan::New<String>("id").ToLocalChecked(),
-                Nan::New<String>(id).ToLocalChecked());
-        }
-        Local<Array> links = Nan::New<Array>();
-        // Extracts all links.
-        // 4.2.7. The "atom:link" Element
-        xml_node<char> *linkNode = itemNode->first_node("link");
-        int linkIndex = 0;
-        while (linkNode) {
-            Local<Object> link = Nan::New<Object>();
-            xml_attribute<char> *relAttr = linkNode->first_attribute("rel");
-            xml_attribute<char> *hrefAttr = linkNode->first_attribute("href");
-            xml_attribute<char> *typeAttr = linkNode->first_attribute("type");
-            xml_attribute<char> *hreflangAttr = linkNode->first_attribute("hreflang");
-            xml_attribute<char> *titleAttr = linkNode->first_attribute("title");
-            xml_attribute<char> *lengthAttr = linkNode->first_attribute("length");
-            if (relAttr) {
-                Nan::Set(link, Nan::New<String>("rel").ToLocalChecked(),
-                    Nan::New<String>(relAttr->value()).ToLocalChecked());
-            }
-            if (hrefAttr) {
-                Nan::Set(link, Nan::New<String>("href").ToLocalChecked(),
-                    Nan::New<String>(hrefAttr->value()).ToLocalChecked());
-            }
-            if (typeAttr) {
-                Nan::Set(link, Nan::New<String>("type").ToLocalChecked(),
-                    Nan::New<String>(typeAttr->value()).ToLocalChecked());
-            }
-            if (hreflangAttr) {
-                Nan::Set(link, Nan::New<String>("hreflang").ToLocalChecked(),
-                    Nan::New<String>(hreflangAttr->value()).ToLocalChecked());
-            }
-            if (titleAttr) {
-                Nan::Set(link, Nan::New<String>("title").ToLocalChecked(),
-                    Nan::New<String>(titleAttr->value()).ToLocalChecked());
-            }
-            if (lengthAttr) {
-                Nan::Set(link, Nan::New<String>("length").ToLocalChecked(),
-                    Nan::New<String>(lengthAttr->value()).ToLocalChecked());
-            }
-            xml_node<char> *textNode = linkNode->first_node();
-            // This is not by spec but some feeds
-            // put URL/IRI into link's text node like:
-            // <link>http://example.com</link>
-            if (textNode) {
-                Nan::Set(link, Nan::New<String>("text").ToLocalChecked(),
-                    Nan::New<String>(textNode->value()).ToLocalChecked());
+    }
+
+    void HandleOKCallback() {
+        Nan::HandleScope scope;
+        Local<Value> argv[] = { Nan::Null(), job.result(*data, options) };
+        callback->Call(2, argv, async_resource);
+    }
+
+    void HandleErrorCallback() {
+        Nan::HandleScope scope;
+        Local<Value> argv[] = { job.result(*data, options) };
+        callback->Call(1, argv, async_resource);
+    }
+
+private:
+    ParseJob job;
+    const IsolateData *data;
+    ParseOptions options;
+};
+
+// Batch of parse jobs run on multiple native
+// threads. Threads take the next unprocessed job
+// until all jobs are done.
+
+class ParseBatch {
+public:
+    ParseBatch(const ParseOptions &options, unsigned int concurrency)
+        : options(options), concurrency(concurrency), next(0) {
+        uv_mutex_init(&mutex);
+    }
+
+    ~ParseBatch() {
+        for (size_t i = 0; i < jobs.size(); i++) {
+            delete jobs[i];
+        }
+        uv_mutex_destroy(&mutex);
+    }
+
+    // Copies the inputs from the given array.
+    // Must be called on the main thread. With
+    // async the batch runs after the call returns.
+    void setInputs(const Local<Array> &xmls, bool async) {
+        uint32_t length = xmls->Length();
+        jobs.reserve(length);
+        for (uint32_t i = 0; i < length; i++) {
+            ParseJob *job = new ParseJob();
+            job->setInput(Nan::Get(xmls, i).ToLocalChecked(), options, async);
+            jobs.push_back(job);
+        }
+    }
+
+    // Runs all jobs. Blocks until done.
+    void run() {
+        unsigned int threadCount = concurrency;
+        if (threadCount > jobs.size()) {
+            threadCount = jobs.size();
+        }
+        if (threadCount <= 1) {
+            work(this);
+            return;
+        }
+        // The calling thread works too.
+        std::vector<uv_thread_t> threads(threadCount - 1);
+        size_t started = 0;
+        for (; started < threads.size(); started++) {
+            if (uv_thread_create(&threads[started], work, this) != 0) {
+                break;
             }
-            Nan::Set(links, linkIndex, link);
-            linkIndex++;
-            linkNode = linkNode->next_sibling("link");
-        }
-        Nan::Set(item, Nan::New<String>("links").ToLocalChecked(), links);
-        // Extract the item title.
-        char const *title = readTextNode(itemNode, "title", deallocate);
-        if (title) {
-            Nan::Set(item, Nan::New<String>("title").ToLocalChecked(),
-                Nan::New<String>(title).ToLocalChecked());
-        }
-        // Extract the published property.
-        char const *date = readTextNode(itemNode, "published", deallocate);
-        if (date) {
-            Nan::Set(item, Nan::New<String>("date").ToLocalChecked(),
-                Nan::New<String>(date).ToLocalChecked());
-        }
-        // Extract the updated property.
-        // Overwrites date set from published.
-        date = readTextNode(itemNode, "updated", deallocate);
-        if (date) {
-            Nan::Set(item, Nan::New<String>("date").ToLocalChecked(),
-                Nan::New<String>(date).ToLocalChecked());
-        }
-        // Extract the item author.
-        parseAtomAuthor(itemNode, item, deallocate);
-        if (extractContent) {
-            // Extract the item summary.
-            char const *summary = readTextNode(itemNode, "summary", deallocate);
-            if (summary) {
-                Nan::Set(item, Nan::New<String>("summary").ToLocalChecked(),
-                    Nan::New<String>(summary).ToLocalChecked());
+        }
+        work(this);
+        for (size_t i = 0; i < started; i++) {
+            uv_thread_join(&threads[i]);
+        }
+    }
+
+    // Builds the array of results in input order.
+    // Failed inputs are represented by error objects.
+    Local<Array> results(const IsolateData &data) const {
+        Local<Array> array = Nan::New<Array>(jobs.size());
+        for (size_t i = 0; i < jobs.size(); i++) {
+            Nan::Set(array, i, jobs[i]->result(data, options));
+        }
+        return array;
+    }
+
+private:
+    static void work(void *arg) {
+        ParseBatch *batch = static_cast<ParseBatch*>(arg);
+        while (true) {
+            uv_mutex_lock(&batch->mutex);
+            size_t index = batch->next++;
+            uv_mutex_unlock(&batch->mutex);
+            if (index >= batch->jobs.size()) {
+                break;
             }
-            // Extract the item content.
-            char const *content = readTextNode(itemNode, "content", deallocate);
-            if (content) {
-                Nan::Set(item, Nan::New<String>("content").ToLocalChecked(),
-                    Nan::New<String>(content).ToLocalChecked());
+            batch->jobs[index]->run(batch->options);
+        }
+    }
+
+    std::vector<ParseJob*> jobs;
+    ParseOptions options;
+    unsigned int concurrency;
+    size_t next;
+    uv_mutex_t mutex;
+
+    ParseBatch(const ParseBatch&);
+    ParseBatch &operator=(const ParseBatch&);
+};
+
+// Runs the batch off the main thread.
+
+class ParseBatchWorker : public Nan::AsyncWorker {
+public:
+    ParseBatchWorker(Nan::Callback *callback, const IsolateData *data, ParseBatch *batch)
+        : Nan::AsyncWorker(callback, "fast-feed:parseMany"), data(data), batch(batch) {}
+
+    ~ParseBatchWorker() {
+        delete batch;
+    }
+
+    void Execute() {
+        batch->run();
+    }
+
+    void HandleOKCallback() {
+        Nan::HandleScope scope;
+        Local<Value> argv[] = { Nan::Null(), batch->results(*data) };
+        callback->Call(2, argv, async_resource);
+    }
+
+private:
+    const IsolateData *data;
+    ParseBatch *batch;
+};
+
+// Streaming parser object. The feed is given in
+// chunks with write() that returns the items
+// completed by the chunk.
+
+class StreamParser : public Nan::ObjectWrap {
+public:
+    static Local<Function> Init(const Local<External> &data) {
+        Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New, data);
+        tpl->SetClassName(Nan::New<String>("StreamParser").ToLocalChecked());
+        tpl->InstanceTemplate()->SetInternalFieldCount(1);
+        Nan::SetPrototypeMethod(tpl, "write", Write);
+        Nan::SetPrototypeMethod(tpl, "end", End);
+        Nan::SetPrototypeMethod(tpl, "header", Header);
+        return Nan::GetFunction(tpl).ToLocalChecked();
+    }
+
+private:
+    StreamParser(const IsolateData *data, const ParseOptions &options)
+        : data(data), options(options), splitter(options), ended(false), failed(false) {}
+
+    // new StreamParser(options).
+    static NAN_METHOD(New) {
+        if (!info.IsConstructCall()) {
+            Nan::ThrowTypeError("Use the new operator to create a StreamParser");
+            return;
+        }
+        IsolateData *data = getIsolateData(info);
+        ParseOptions options;
+        if (!readOptions(*data, info[0], options)) {
+            return;
+        }
+        // There is no single parse to measure
+        // or to write into one buffer.
+        options.stats = false;
+        options.binary = false;
+        StreamParser *parser = new StreamParser(data, options);
+        parser->Wrap(info.This());
+        info.GetReturnValue().Set(info.This());
+    }
+
+    // write(chunk). Returns the array of items.
+    static NAN_METHOD(Write) {
+        StreamParser *parser = Nan::ObjectWrap::Unwrap<StreamParser>(info.Holder());
+        if (info.Length() < 1) {
+            Nan::ThrowTypeError("Wrong number of arguments");
+            return;
+        }
+        if (!parser->usable()) {
+            return;
+        }
+        bool ok;
+        try {
+            if (info[0]->IsArrayBufferView()) {
+                Nan::TypedArrayContents<char> bytes(info[0]);
+                ok = parser->splitter.write(*bytes, bytes.length(), parser->error);
+            } else {
+                Nan::Utf8String string(info[0]);
+                ok = parser->splitter.write(*string, string.length(), parser->error);
             }
+        } catch(std::bad_alloc &e) {
+            parser->error = OUT_OF_MEMORY;
+            ok = false;
         }
-        // Extracts extensions when configured to.
-        if (extractExtensions) {
-            doExtractExtensions(itemNode, item, deallocate);
+        if (!ok) {
+            parser->fail();
+            return;
         }
-        Nan::Set(items, i, item);
-        itemNode = itemNode->next_sibling("entry");
-        i++;
+        info.GetReturnValue().Set(parser->items());
     }
-    Nan::Set(feed, Nan::New<String>("items").ToLocalChecked(), items);
-    // Free created buffers.
-    deallocateStrings(deallocate);
-}
 
-// Creates an array of strings which represent the categories of an item node.
+    // end(). Throws when the feed is incomplete.
+    static NAN_METHOD(End) {
+        StreamParser *parser = Nan::ObjectWrap::Unwrap<StreamParser>(info.Holder());
+        if (!parser->usable()) {
+            return;
+        }
+        parser->ended = true;
+        bool ok;
+        try {
+            ok = parser->splitter.end(parser->error);
+        } catch(std::bad_alloc &e) {
+            parser->error = OUT_OF_MEMORY;
+            ok = false;
+        }
+        if (!ok) {
+            parser->fail();
+        }
+    }
 
-Local<Array> readCategoriesFromItemNode(const xml_node<char> *itemNode, std::vector<char*> &deallocate) {
-    Local<Array> categories = Nan::New<Array>();
-    xml_node<char> *categoryNode = itemNode->first_node("category");
-    int categoryIndex = 0;
-    while (categoryNode) {
-        char const *category = readTextNode(categoryNode, deallocate);
-        if (category) {
-            Local<Object> categoryObject = Nan::New<Object>();
-            Nan::Set(categoryObject, Nan::New<String>("name").ToLocalChecked(),
-                Nan::New<String>(category).ToLocalChecked());
-            Nan::Set(categories, categoryIndex, categoryObject);
+    // header(). Returns the feed object without
+    // items or undefined when not parsed yet.
+    static NAN_METHOD(Header) {
+        StreamParser *parser = Nan::ObjectWrap::Unwrap<StreamParser>(info.Holder());
+        if (parser->splitter.hasHeader()) {
+            info.GetReturnValue().Set(buildFeed(*parser->data, parser->splitter.header(), parser->options));
         }
-        categoryNode = categoryNode->next_sibling("category");
-        categoryIndex++;
     }
-    return categories;
-}
 
-// Parses the RSS feed.
+    // Throws when the parser has failed or ended.
+    bool usable() const {
+        if (failed) {
+            Nan::ThrowTypeError(error.c_str());
+            return false;
+        }
+        if (ended) {
+            Nan::ThrowError("The parser has ended");
+            return false;
+        }
+        return true;
+    }
 
-void parseRssFeed(xml_node<char> *rssNode, const Local<Object> &feed, bool extractContent, bool extractExtensions) {
-    // Vector string pointers not
-    // deallocated by RapidXML.
-    std::vector<char*> deallocate;
-    Nan::Set(feed, Nan::New<String>("type").ToLocalChecked(),
-        Nan::New<String>("rss").ToLocalChecked());
-    xml_node<char> *channelNode = rssNode->first_node("channel");
-    if (!channelNode) {
-        Nan::ThrowTypeError("Invalid RSS channel.");
-        return;
+    void fail() {
+        failed = true;
+        Nan::ThrowTypeError(error.c_str());
     }
-    // Extracts the title property.
-    char const *title = readTextNode(channelNode, "title", deallocate);
-    if (title) {
-        Nan::Set(feed, Nan::New<String>("title").ToLocalChecked(),
-            Nan::New<String>(title).ToLocalChecked());
-    }
-    // Extracts the description property.
-    char const *description = readTextNode(channelNode, "description", deallocate);
-    if (description) {
-        Nan::Set(feed, Nan::New<String>("description").ToLocalChecked(),
-            Nan::New<String>(description).ToLocalChecked());
-    }
-    // Extracts the link property.
-    char const *link = readTextNode(channelNode, "link", deallocate);
-    if (link) {
-        Nan::Set(feed, Nan::New<String>("link").ToLocalChecked(),
-            Nan::New<String>(link).ToLocalChecked());
-    }
-    // Extracts the author property.
-    char const *author = readTextNode(channelNode, "author", deallocate);
-    if (author) {
-        Nan::Set(feed, Nan::New<String>("author").ToLocalChecked(),
-            Nan::New<String>(author).ToLocalChecked());
-    }
-    // Extracts extensions when configured to.
-    if (extractExtensions) {
-        doExtractExtensions(channelNode, feed, deallocate);
-    }
-    // Extract all channel items.
-    Local<Array> items = Nan::New<Array>();
-    xml_node<char> *itemNode = channelNode->first_node("item");
-    int i = 0;
-    while (itemNode) {
-        Local<Object> item = Nan::New<Object>();
-        // Extracts the categories.
-        Local<Array> categories = readCategoriesFromItemNode(itemNode, deallocate);
-        if (categories->Length() > 0) {
-            Nan::Set(item, Nan::New<String>("categories").ToLocalChecked(), categories);
-        }
-        // Extracts the guid property.
-        char const *guid = readTextNode(itemNode, "guid", deallocate);
-        if (guid) {
-            Nan::Set(item, Nan::New<String>("id").ToLocalChecked(),
-                Nan::New<String>(guid).ToLocalChecked());
-        }
-        // Extracts the link property.
-        char const *link = readTextNode(itemNode, "link", deallocate);
-        if (link) {
-            Nan::Set(item, Nan::New<String>("link").ToLocalChecked(),
-                Nan::New<String>(link).ToLocalChecked());
-        }
-        // Extracts the pubDate property.
-        char const *date = readTextNode(itemNode, "pubDate", deallocate);
-        if (date) {
-            Nan::Set(item, Nan::New<String>("date").ToLocalChecked(),
-                Nan::New<String>(date).ToLocalChecked());
-        }
-        // Sometimes given in Dublin Core extension.
-        date = readTextNode(itemNode, "dc:date", deallocate);
-        if (date) {
-            Nan::Set(item, Nan::New<String>("date").ToLocalChecked(),
-                Nan::New<String>(date).ToLocalChecked());
-        }
-        // Extract the item title.
-        char const *title = readTextNode(itemNode, "title", deallocate);
-        if (title) {
-            Nan::Set(item, Nan::New<String>("title").ToLocalChecked(),
-                Nan::New<String>(title).ToLocalChecked());
-        }
-        // Extract the item author.
-        char const *author = readTextNode(itemNode, "author", deallocate);
-        if (author) {
-            Nan::Set(item, Nan::New<String>("author").ToLocalChecked(),
-                Nan::New<String>(author).ToLocalChecked());
-        }
-        // Extract the enclosure if it is set.
-        doExtractEnclosure(itemNode, item);
-        if (extractContent) {
-            // Extract the item description.
-            char const *description = readTextNode(itemNode, "description", deallocate);
-            if (description) {
-                Nan::Set(item, Nan::New<String>("description").ToLocalChecked(),
-                    Nan::New<String>(description).ToLocalChecked());
+
+    // Builds the items extracted by the last call.
+    Local<Array> items() const {
+        const Feed &batch = splitter.items();
+        Local<Array> array = Nan::New<Array>(batch.items.size());
+        for (size_t i = 0; i < batch.items.size(); i++) {
+            if (splitter.isAtom()) {
+                Nan::Set(array, i, buildAtomItem(*data, batch.items[i], options));
+            } else {
+                Nan::Set(array, i, buildRssItem(*data, batch.items[i], options));
             }
-            // <content:encoded> is a popular RSS extension.
-            // More info: https://developer.mozilla.org/en-US/docs/Web/RSS/Article/Why_RSS_Content_Module_is_Popular_-_Including_HTML_Contents
-            char const *content = readTextNode(itemNode, "content:encoded", deallocate);
-            if (content) {
-                Nan::Set(item, Nan::New<String>("content").ToLocalChecked(),
-                    Nan::New<String>(content).ToLocalChecked());
+        }
+        return array;
+    }
+
+    const IsolateData *data;
+    ParseOptions options;
+    FeedSplitter splitter;
+    std::string error;
+    bool ended;
+    bool failed;
+};
+
+// Reusable parser object. Keeps the input buffer,
+// the document and its memory blocks between the
+// calls. Memory above the high-water mark is freed
+// after each parse.
+
+class Parser : public Nan::ObjectWrap {
+public:
+    static Local<Function> Init(const Local<External> &data) {
+        Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New, data);
+        tpl->SetClassName(Nan::New<String>("Parser").ToLocalChecked());
+        tpl->InstanceTemplate()->SetInternalFieldCount(1);
+        Nan::SetPrototypeMethod(tpl, "parse", Parse);
+        Nan::SetPrototypeMethod(tpl, "parseAsync", ParseAsync);
+        return Nan::GetFunction(tpl).ToLocalChecked();
+    }
+
+    // Parses the input. Runs on any thread.
+    void run() {
+        CacheScope scope(&cache);
+        feed.clear();
+        ok = parseInput(*doc, *input, feed, options, error) && checkBinary(feed, options, error);
+        // The extracted values point into the input.
+        doc->clear();
+        cache.trim();
+    }
+
+    bool succeeded() const {
+        return ok;
+    }
+
+    // Builds the feed or the error object
+    // and trims the input buffer. The buffer
+    // is replaced when external strings use it.
+    Local<Value> result() {
+        Local<Value> value;
+        if (ok) {
+            InputScope scope(*data, input);
+            value = buildResult(*data, feed, options);
+        } else {
+            value = Nan::TypeError(error.c_str());
+        }
+        feed.clear();
+        if (input->shared() || input->capacity() > highWaterMark) {
+            input->unref();
+            input = new SharedInput();
+        }
+        busy = false;
+        return value;
+    }
+
+private:
+    Parser(const IsolateData *data, const ParseOptions &options, size_t highWaterMark)
+        : data(data), options(options), highWaterMark(highWaterMark),
+        cache(highWaterMark), input(new SharedInput()), doc(new xml_document<char>()), ok(false), busy(false) {
+        doc->set_allocator(allocateBlock, releaseBlock);
+    }
+
+    ~Parser() {
+        CacheScope scope(&cache);
+        delete doc;
+        input->unref();
+    }
+
+    // new Parser(options).
+    static NAN_METHOD(New) {
+        if (!info.IsConstructCall()) {
+            Nan::ThrowTypeError("Use the new operator to create a Parser");
+            return;
+        }
+        IsolateData *data = getIsolateData(info);
+        ParseOptions options;
+        if (!readOptions(*data, info[0], options)) {
+            return;
+        }
+        size_t highWaterMark = DEFAULT_HIGH_WATER_MARK;
+        if (info[0]->IsObject()) {
+            Local<Value> value = Nan::Get(info[0].As<Object>(), data->key(KEY_HIGH_WATER_MARK)).ToLocalChecked();
+            if (!value->IsUndefined()) {
+                highWaterMark = Nan::To<uint32_t>(value).FromMaybe(0);
             }
         }
-        // Extracts extensions when configured to.
-        if (extractExtensions) {
-            doExtractExtensions(itemNode, item, deallocate);
+        Parser *parser = new Parser(data, options, highWaterMark);
+        parser->Wrap(info.This());
+        info.GetReturnValue().Set(info.This());
+    }
+
+    // parse(xml).
+    static NAN_METHOD(Parse) {
+        Parser *parser = Nan::ObjectWrap::Unwrap<Parser>(info.Holder());
+        if (!parser->start(info, false)) {
+            return;
+        }
+        parser->run();
+        Local<Value> result = parser->result();
+        if (!parser->ok) {
+            Nan::ThrowError(result);
+            return;
+        }
+        info.GetReturnValue().Set(result);
+    }
+
+    // parseAsync(xml, cb).
+    static NAN_METHOD(ParseAsync);
+
+    // Copies the input into the reused buffer.
+    // Throws when a parse is in progress.
+    bool start(const Nan::FunctionCallbackInfo<Value> &info, bool async) {
+        if (info.Length() < 1) {
+            Nan::ThrowTypeError("Wrong number of arguments");
+            return false;
+        }
+        if (busy) {
+            Nan::ThrowError("The parser is busy");
+            return false;
+        }
+        input->assign(info[0], options, async);
+        busy = true;
+        return true;
+    }
+
+    static const size_t DEFAULT_HIGH_WATER_MARK = 4 * 1024 * 1024;
+
+    const IsolateData *data;
+    ParseOptions options;
+    size_t highWaterMark;
+    BlockCache cache;
+    SharedInput *input;
+    xml_document<char> *doc;
+    Feed feed;
+    std::string error;
+    bool ok;
+    bool busy;
+};
+
+// Runs the reusable parser on the
+// libuv thread pool.
+
+class ParserWorker : public Nan::AsyncWorker {
+public:
+    ParserWorker(Nan::Callback *callback, Parser *parser, const Local<Object> &object)
+        : Nan::AsyncWorker(callback, "fast-feed:Parser.parse"), parser(parser) {
+        // Keeps the parser alive until done.
+        SaveToPersistent("parser", object);
+    }
+
+    void Execute() {
+        parser->run();
+    }
+
+    void HandleOKCallback() {
+        Nan::HandleScope scope;
+        bool ok = parser->succeeded();
+        Local<Value> result = parser->result();
+        if (!ok) {
+            Local<Value> argv[] = { result };
+            callback->Call(1, argv, async_resource);
+        } else {
+            Local<Value> argv[] = { Nan::Null(), result };
+            callback->Call(2, argv, async_resource);
         }
-        Nan::Set(items, i, item);
-        itemNode = itemNode->next_sibling("item");
-        i++;
     }
-    Nan::Set(feed, Nan::New<String>("items").ToLocalChecked(), items);
-    // Free created buffers.
-    deallocateStrings(deallocate);
+
+private:
+    Parser *parser;
+};
+
+NAN_METHOD(Parser::ParseAsync) {
+    Parser *parser = Nan::ObjectWrap::Unwrap<Parser>(info.Holder());
+    if (info.Length() < 2 || !info[1]->IsFunction()) {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
+    }
+    if (!parser->start(info, true)) {
+        return;
+    }
+    Nan::Callback *callback = new Nan::Callback(info[1].As<Function>());
+    Nan::AsyncQueueWorker(new ParserWorker(callback, parser, info.Holder()));
 }
 
+// Default number of threads for batch parsing.
+
+unsigned int defaultConcurrency() {
+    uv_cpu_info_t *cpus;
+    int count = 0;
+    if (uv_cpu_info(&cpus, &count) != 0) {
+        return 1;
+    }
+    uv_free_cpu_info(cpus, count);
+    return count > 0 ? count : 1;
+}
+
+// parse(xml, options).
+
 NAN_METHOD(ParseFeed) {
     if (info.Length() < 1) {
         Nan::ThrowTypeError("Wrong number of arguments");
         return;
     }
-    Nan::Utf8String xml(info[0]);
-    xml_document<char> doc;
-    try {
-        doc.parse<0>(*xml);
-    } catch(rapidxml::parse_error &e) {
-        std::pair<int, int> loc = findErrorLine(*xml, e.where<char>());
-        std::stringstream err;
-        err << "Error on line " << loc.first;
-        err << ", column " << loc.second;
-        err << ": " << e.what();
-        std::string strErr = err.str();
-        Nan::ThrowTypeError(strErr.c_str());
+    IsolateData *data = getIsolateData(info);
+    ParseOptions options;
+    if (!readOptions(*data, info[1], options)) {
+        return;
+    }
+    ParseJob job;
+    job.setInput(info[0], options, false);
+    job.run(options);
+    if (!job.ok) {
+        Nan::ThrowError(job.result(*data, options));
         return;
     }
-    bool extractContent = true;
-    if (info.Length() >= 2) {
-        extractContent = Nan::To<bool>(info[1]).FromMaybe(true);
-    }
-    bool extractExtensions = false;
-    if (info.Length() >= 3) {
-        extractExtensions = Nan::To<bool>(info[2]).FromMaybe(false);
-    }
-    // Creates new object to store the feed
-    // contents.
-    Local<Object> feed = Nan::New<Object>();
-    // Tries to get either <rss> or <feed> node.
-    xml_node<> *rssNode = doc.first_node("rss");
-    if (rssNode) {
-        parseRssFeed(rssNode, feed, extractContent, extractExtensions);
+    info.GetReturnValue().Set(job.result(*data, options));
+}
+
+// parseAsync(xml, options, cb).
+
+NAN_METHOD(ParseFeedAsync) {
+    if (info.Length() < 3 || !info[2]->IsFunction()) {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
+    }
+    IsolateData *data = getIsolateData(info);
+    ParseOptions options;
+    if (!readOptions(*data, info[1], options)) {
+        return;
+    }
+    Nan::Callback *callback = new Nan::Callback(info[2].As<Function>());
+    Nan::AsyncQueueWorker(new ParseWorker(callback, data, info[0], options));
+}
+
+// parseMany(xmls, options, [cb]).
+// Concurrency option 0 uses the number of CPUs.
+
+NAN_METHOD(ParseMany) {
+    if (info.Length() < 1) {
+        Nan::ThrowTypeError("Wrong number of arguments");
+        return;
+    }
+    if (!info[0]->IsArray()) {
+        Nan::ThrowTypeError("Expected an array of feeds");
+        return;
+    }
+    IsolateData *data = getIsolateData(info);
+    ParseOptions options;
+    if (!readOptions(*data, info[1], options)) {
+        return;
+    }
+    unsigned int concurrency = 0;
+    if (info[1]->IsObject()) {
+        Local<Value> value = Nan::Get(info[1].As<Object>(), data->key(KEY_CONCURRENCY)).ToLocalChecked();
+        concurrency = Nan::To<uint32_t>(value).FromMaybe(0);
+    }
+    if (concurrency == 0) {
+        concurrency = defaultConcurrency();
+    }
+    bool async = info.Length() >= 3 && info[2]->IsFunction();
+    ParseBatch *batch = new ParseBatch(options, concurrency);
+    batch->setInputs(info[0].As<Array>(), async);
+    if (async) {
+        Nan::Callback *callback = new Nan::Callback(info[2].As<Function>());
+        Nan::AsyncQueueWorker(new ParseBatchWorker(callback, data, batch));
     } else {
-        xml_node<> *feedNode = doc.first_node("feed");
-        if (feedNode) {
-            parseAtomFeed(feedNode, feed, extractContent, extractExtensions);
-        } else {
-            Nan::ThrowTypeError("Invalid feed.");
-            return;
-        }
+        batch->run();
+        info.GetReturnValue().Set(batch->results(*data));
+        delete batch;
     }
-    info.GetReturnValue().Set(feed);
+}
+
+// Frees the isolate data when the environment
+// (the main thread or a worker) is torn down.
+
+void freeIsolateData(void *data) {
+    delete static_cast<IsolateData*>(data);
 }
 
 NAN_MODULE_INIT(InitAll) {
+  // Lives as long as the environment. Each
+  // worker thread gets its own.
+  IsolateData *isolateData = new IsolateData();
+#if NODE_MAJOR_VERSION >= 11
+  node::AddEnvironmentCleanupHook(Isolate::GetCurrent(), freeIsolateData, isolateData);
+#endif
+  Local<External> data = Nan::New<External>(isolateData);
   Nan::Set(target, Nan::New<String>("parse").ToLocalChecked(),
-      Nan::GetFunction(Nan::New<FunctionTemplate>(ParseFeed)).ToLocalChecked());
+      Nan::GetFunction(Nan::New<FunctionTemplate>(ParseFeed, data)).ToLocalChecked());
+  Nan::Set(target, Nan::New<String>("parseAsync").ToLocalChecked(),
+      Nan::GetFunction(Nan::New<FunctionTemplate>(ParseFeedAsync, data)).ToLocalChecked());
+  Nan::Set(target, Nan::New<String>("parseMany").ToLocalChecked(),
+      Nan::GetFunction(Nan::New<FunctionTemplate>(ParseMany, data)).ToLocalChecked());
+  Nan::Set(target, Nan::New<String>("StreamParser").ToLocalChecked(), StreamParser::Init(data));
+  Nan::Set(target, Nan::New<String>("Parser").ToLocalChecked(), Parser::Init(data));
 }
 
-NODE_MODULE(parser, InitAll)
+NAN_MODULE_WORKER_ENABLED(parser, InitAll)
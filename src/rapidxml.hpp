@@ -13,6 +13,9 @@
     #include <new>          // For placement new
 #endif
 
+#include "rapidxml_simd.hpp"    // For vectorized scanning
+#include "rapidxml_entities.hpp"    // For HTML named character references
+
 // On MSVC, disable "conditional expression is constant" warning (level 4). 
 // This warning is almost impossible to avoid with certain types of templated code
 #ifdef _MSC_VER
@@ -246,6 +249,14 @@ namespace rapidxml
     //! See xml_document::parse() function.
     const int parse_normalize_whitespace = 0x800;
 
+    //! Parse flag instructing the parser to also translate HTML5 named character references,
+    //! for example &amp;nbsp; and &amp;eacute;, in data and attribute values.
+    //! By default, only the XML entities are translated. Only works with char.
+    //! Can be combined with other flags by use of | operator.
+    //! <br><br>
+    //! See xml_document::parse() function.
+    const int parse_html_entities = 0x1000;
+
     // Compound flags
     
     //! Parse flags which represent default behaviour of the parser. 
@@ -536,6 +547,16 @@ namespace rapidxml
             init();
         }
 
+        //! Gets the number of bytes used from the pool.
+        //! Includes the alignment padding and the unused ends of the full dynamic pools.
+        //! \return Number of bytes used from the static and the dynamic pools.
+        std::size_t used_size() const
+        {
+            if (m_begin == m_static_memory)
+                return m_ptr - m_static_memory;
+            return sizeof(m_static_memory) + m_dynamic_size - (m_end - m_ptr);
+        }
+
         //! Sets or resets the user-defined memory allocation functions for the pool.
         //! This can only be called when no memory is allocated from the pool yet, otherwise results are undefined.
         //! Allocation function must not return invalid pointer on failure. It should either throw,
@@ -568,6 +589,7 @@ namespace rapidxml
             m_begin = m_static_memory;
             m_ptr = align(m_begin);
             m_end = m_static_memory + sizeof(m_static_memory);
+            m_dynamic_size = 0;
         }
         
         char *align(char *ptr)
@@ -620,6 +642,7 @@ namespace rapidxml
                 m_begin = raw_memory;
                 m_ptr = pool + sizeof(header);
                 m_end = raw_memory + alloc_size;
+                m_dynamic_size += alloc_size;
 
                 // Calculate aligned pointer again using new pool
                 result = align(m_ptr);
@@ -633,6 +656,7 @@ namespace rapidxml
         char *m_begin;                                      // Start of raw memory making up current pool
         char *m_ptr;                                        // First free byte in current pool
         char *m_end;                                        // One past last available byte in current pool
+        std::size_t m_dynamic_size;                         // Total size of the dynamic pools
         char m_static_memory[RAPIDXML_STATIC_POOL_SIZE];    // Static raw memory
         alloc_func *m_alloc_func;                           // Allocator function, or 0 if default is to be used
         free_func *m_free_func;                             // Free function, or 0 if default is to be used
@@ -1427,6 +1451,8 @@ namespace rapidxml
         // Detect whitespace character
         struct whitespace_pred
         {
+            static const Ch stop_1 = Ch(0);
+            static const Ch stop_2 = Ch(0);
             static unsigned char test(Ch ch)
             {
                 return internal::lookup_tables<0>::lookup_whitespace[static_cast<unsigned char>(ch)];
@@ -1436,6 +1462,8 @@ namespace rapidxml
         // Detect node name character
         struct node_name_pred
         {
+            static const Ch stop_1 = Ch(0);
+            static const Ch stop_2 = Ch(0);
             static unsigned char test(Ch ch)
             {
                 return internal::lookup_tables<0>::lookup_node_name[static_cast<unsigned char>(ch)];
@@ -1445,6 +1473,8 @@ namespace rapidxml
         // Detect attribute name character
         struct attribute_name_pred
         {
+            static const Ch stop_1 = Ch(0);
+            static const Ch stop_2 = Ch(0);
             static unsigned char test(Ch ch)
             {
                 return internal::lookup_tables<0>::lookup_attribute_name[static_cast<unsigned char>(ch)];
@@ -1454,6 +1484,8 @@ namespace rapidxml
         // Detect text character (PCDATA)
         struct text_pred
         {
+            static const Ch stop_1 = Ch('<');
+            static const Ch stop_2 = Ch('<');
             static unsigned char test(Ch ch)
             {
                 return internal::lookup_tables<0>::lookup_text[static_cast<unsigned char>(ch)];
@@ -1463,6 +1495,8 @@ namespace rapidxml
         // Detect text character (PCDATA) that does not require processing
         struct text_pure_no_ws_pred
         {
+            static const Ch stop_1 = Ch('<');
+            static const Ch stop_2 = Ch('&');
             static unsigned char test(Ch ch)
             {
                 return internal::lookup_tables<0>::lookup_text_pure_no_ws[static_cast<unsigned char>(ch)];
@@ -1472,6 +1506,8 @@ namespace rapidxml
         // Detect text character (PCDATA) that does not require processing
         struct text_pure_with_ws_pred
         {
+            static const Ch stop_1 = Ch(0);
+            static const Ch stop_2 = Ch(0);
             static unsigned char test(Ch ch)
             {
                 return internal::lookup_tables<0>::lookup_text_pure_with_ws[static_cast<unsigned char>(ch)];
@@ -1482,6 +1518,8 @@ namespace rapidxml
         template<Ch Quote>
         struct attribute_value_pred
         {
+            static const Ch stop_1 = Quote;
+            static const Ch stop_2 = Quote;
             static unsigned char test(Ch ch)
             {
                 if (Quote == Ch('\''))
@@ -1496,6 +1534,8 @@ namespace rapidxml
         template<Ch Quote>
         struct attribute_value_pure_pred
         {
+            static const Ch stop_1 = Quote;
+            static const Ch stop_2 = Ch('&');
             static unsigned char test(Ch ch)
             {
                 if (Quote == Ch('\''))
@@ -1554,10 +1594,13 @@ namespace rapidxml
         }
 
         // Skip characters until predicate evaluates to true
+        // Predicates with stop characters are first scanned vectorized
         template<class StopPred, int Flags>
         static void skip(Ch *&text)
         {
             Ch *tmp = text;
+            if (StopPred::stop_1)
+                tmp = internal::find_stop(tmp, StopPred::stop_1, StopPred::stop_2);
             while (StopPred::test(*tmp))
                 ++tmp;
             text = tmp;
@@ -1688,6 +1731,17 @@ namespace rapidxml
                             break;
 
                         }
+
+                        // HTML named character reference
+                        if (Flags & parse_html_entities)
+                        {
+                            std::size_t consumed = internal::expand_html_entity(src, dest);
+                            if (consumed)
+                            {
+                                src += consumed;
+                                continue;
+                            }
+                        }
                     }
                 }
                 
@@ -1780,7 +1834,7 @@ namespace rapidxml
                 {
                     if (!text[0])
                         RAPIDXML_PARSE_ERROR("unexpected end of data", text);
-                    ++text;
+                    text = internal::find_stop(text + 1, Ch('-'), Ch('-'));
                 }
                 text += 3;     // Skip '-->'
                 return 0;      // Do not produce comment node
@@ -1794,7 +1848,7 @@ namespace rapidxml
             {
                 if (!text[0])
                     RAPIDXML_PARSE_ERROR("unexpected end of data", text);
-                ++text;
+                text = internal::find_stop(text + 1, Ch('-'), Ch('-'));
             }
 
             // Create comment node
@@ -2005,7 +2059,7 @@ namespace rapidxml
                 {
                     if (!text[0])
                         RAPIDXML_PARSE_ERROR("unexpected end of data", text);
-                    ++text;
+                    text = internal::find_stop(text + 1, Ch(']'), Ch(']'));
                 }
                 text += 3;      // Skip ]]>
                 return 0;       // Do not produce CDATA node
@@ -2017,7 +2071,7 @@ namespace rapidxml
             {
                 if (!text[0])
                     RAPIDXML_PARSE_ERROR("unexpected end of data", text);
-                ++text;
+                text = internal::find_stop(text + 1, Ch(']'), Ch(']'));
             }
 
             // Create new cdata node
@@ -0,0 +1,144 @@
+#ifndef RAPIDXML_SIMD_HPP_INCLUDED
+#define RAPIDXML_SIMD_HPP_INCLUDED
+
+//! \file rapidxml_simd.hpp This file contains vectorized character scanning used by rapidxml parser
+
+// SSE2 is always available on x86-64. AVX2 is used when the compiler
+// supports function level target attributes and the CPU supports it.
+// Define RAPIDXML_NO_SIMD to use scalar scanning only.
+#if !defined(RAPIDXML_NO_SIMD)
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define RAPIDXML_SSE2
+        #include <emmintrin.h>
+        #if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+            #define RAPIDXML_AVX2
+            #include <immintrin.h>
+        #endif
+        #ifdef _MSC_VER
+            #include <intrin.h>
+        #endif
+    #endif
+#endif
+
+namespace rapidxml
+{
+    //! \cond internal
+    namespace internal
+    {
+
+        // Scalar scan for zero terminator or one of two stop characters
+        template<class Ch>
+        inline Ch *find_stop_scalar(Ch *text, Ch c1, Ch c2)
+        {
+            while (*text && *text != c1 && *text != c2)
+                ++text;
+            return text;
+        }
+
+#if defined(RAPIDXML_SSE2)
+
+        // Index of the lowest set bit in non-zero mask
+        inline int lowest_bit(unsigned int mask)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return static_cast<int>(index);
+#else
+            return __builtin_ctz(mask);
+#endif
+        }
+
+        // SSE2 scan for zero terminator or one of two stop characters.
+        // Uses aligned loads only. An aligned block never crosses a page
+        // boundary, so reading past the terminator inside the block is safe.
+        inline char *find_stop_sse2(char *text, char c1, char c2)
+        {
+            while (reinterpret_cast<std::size_t>(text) & 15)
+            {
+                if (!*text || *text == c1 || *text == c2)
+                    return text;
+                ++text;
+            }
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i stop1 = _mm_set1_epi8(c1);
+            const __m128i stop2 = _mm_set1_epi8(c2);
+            for (;;)
+            {
+                __m128i block = _mm_load_si128(reinterpret_cast<const __m128i *>(text));
+                __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(block, zero),
+                    _mm_or_si128(_mm_cmpeq_epi8(block, stop1), _mm_cmpeq_epi8(block, stop2)));
+                unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(hit));
+                if (mask)
+                    return text + lowest_bit(mask);
+                text += 16;
+            }
+        }
+
+#endif
+
+#if defined(RAPIDXML_AVX2)
+
+        // AVX2 scan, same as SSE2 scan but with 32 byte blocks
+        __attribute__((target("avx2")))
+        inline char *find_stop_avx2(char *text, char c1, char c2)
+        {
+            while (reinterpret_cast<std::size_t>(text) & 31)
+            {
+                if (!*text || *text == c1 || *text == c2)
+                    return text;
+                ++text;
+            }
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i stop1 = _mm256_set1_epi8(c1);
+            const __m256i stop2 = _mm256_set1_epi8(c2);
+            for (;;)
+            {
+                __m256i block = _mm256_load_si256(reinterpret_cast<const __m256i *>(text));
+                __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(block, zero),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(block, stop1), _mm256_cmpeq_epi8(block, stop2)));
+                unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(hit));
+                if (mask)
+                    return text + lowest_bit(mask);
+                text += 32;
+            }
+        }
+
+#endif
+
+        typedef char *(*find_stop_function)(char *, char, char);
+
+        // Selects the fastest scan supported by the CPU
+        inline find_stop_function select_find_stop()
+        {
+#if defined(RAPIDXML_AVX2)
+            if (__builtin_cpu_supports("avx2"))
+                return find_stop_avx2;
+#endif
+#if defined(RAPIDXML_SSE2)
+            return find_stop_sse2;
+#else
+            return find_stop_scalar<char>;
+#endif
+        }
+
+        // Find zero terminator or one of two stop characters
+        template<class Ch>
+        inline Ch *find_stop(Ch *text, Ch c1, Ch c2)
+        {
+            return find_stop_scalar(text, c1, c2);
+        }
+
+        // Find zero terminator or one of two stop characters, vectorized for char
+        template<>
+        inline char *find_stop<char>(char *text, char c1, char c2)
+        {
+            static const find_stop_function function = select_find_stop();
+            return function(text, c1, c2);
+        }
+
+    }
+    //! \endcond
+}
+
+#endif
@@ -0,0 +1,59 @@
+var assert = require('assert');
+var parser = require('../');
+
+var rss = '<rss><channel><title>Test</title>' +
+    '<item><link>/test</link><pubDate>Tue, 10 Jun 2003 04:00:00 GMT</pubDate>' +
+    '<description>Desc</description></item></channel></rss>';
+
+var atom = '<feed><title>Test</title><entry>' +
+    '<link rel="alternate" type="text/html" href="http://example.com/1" />' +
+    '</entry></feed>';
+
+describe('Async parsing', function() {
+
+    it('should call back asynchronously', function(done) {
+        var sync = true;
+        parser.parse(rss, function(err, feed) {
+            assert.ifError(err);
+            assert.equal(sync, false);
+            assert.equal(feed.items.length, 1);
+            assert.equal(feed.items[0].link, '/test');
+            assert.equal(feed.items[0].description, 'Desc');
+            assert.ok(feed.items[0].date instanceof Date);
+            done();
+        });
+        sync = false;
+    });
+
+    it('should post-process Atom links', function(done) {
+        parser.parse(atom, {}, function(err, feed) {
+            assert.ifError(err);
+            assert.equal(feed.items[0].link, 'http://example.com/1');
+            done();
+        });
+    });
+
+    it('should resolve the promise', function() {
+        return parser.parseAsync(rss, { content: false }).then(function(feed) {
+            assert.equal(feed.type, 'rss');
+            assert.equal(feed.items[0].link, '/test');
+            assert.equal(typeof feed.items[0].description, 'undefined');
+        });
+    });
+
+    it('should reject the promise on invalid input', function() {
+        return parser.parseAsync('<<<<>').then(function() {
+            assert.fail('should not resolve');
+        }, function(err) {
+            assert.ok(err instanceof TypeError);
+        });
+    });
+
+    it('should reject the promise on invalid feed', function() {
+        return parser.parseAsync('<html></html>').then(function() {
+            assert.fail('should not resolve');
+        }, function(err) {
+            assert.equal(err.message, 'Invalid feed.');
+        });
+    });
+});
@@ -31,4 +31,47 @@ describe('Parser (Atom)', function() {
         assert.equal(feed.items[0].link, 'http://example.com/1');
     });
 
-});
\ No newline at end of file
+});
+
+var atom3 = '<feed><title>Test</title><entry>' +
+    '<link rel="self" href="http://example.com/1" />' +
+    '<link rel="alternate" type="application/pdf" href="http://example.com/2" />' +
+    '<link rel="alternate" type="text/html" href="http://example.com/3" />' +
+    '<link rel="alternate" type="application/xml" href="http://example.com/4" />' +
+    '</entry><entry>' +
+    '<link rel="self" href="http://example.com/5" />' +
+    '<link rel="alternate" href="http://example.com/6" />' +
+    '</entry><entry>' +
+    '<link rel="self" href="http://example.com/7" />' +
+    '</entry><entry>' +
+    '</entry></feed>';
+
+describe('Atom link selection', function() {
+
+    it('should prefer the alternate text/html link', function() {
+        var feed = parser.parse(atom3);
+        assert.equal(feed.items[0].link, 'http://example.com/3');
+    });
+
+    it('should take an alternate link without type', function() {
+        var feed = parser.parse(atom3);
+        assert.equal(feed.items[1].link, 'http://example.com/6');
+    });
+
+    it('should take the first link when there is no alternate', function() {
+        var feed = parser.parse(atom3);
+        assert.equal(feed.items[2].link, 'http://example.com/7');
+    });
+
+    it('should have no link when there are no links', function() {
+        var feed = parser.parse(atom3);
+        assert.equal(typeof feed.items[3].link, 'undefined');
+        assert.equal(feed.items[3].links.length, 0);
+    });
+
+    it('should omit the links array with the links: false option', function() {
+        var feed = parser.parse(atom3, { links: false });
+        assert.equal(feed.items[0].link, 'http://example.com/3');
+        assert.equal(typeof feed.items[0].links, 'undefined');
+    });
+});
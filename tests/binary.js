@@ -0,0 +1,120 @@
+var assert = require('assert');
+var parser = require('../');
+
+var rss = '<rss xmlns:itunes="http://www.itunes.com/dtds/podcast-1.0.dtd"><channel>' +
+    '<title>Feed</title><link>http://example.com/</link>' +
+    '<itunes:image href="http://example.com/a.jpg"/>' +
+    '<item><title>Ünïcode ✓</title><pubDate>Tue, 10 Jun 2003 04:00:00 GMT</pubDate>' +
+    '<category>a</category><category>b</category>' +
+    '<enclosure url="http://example.com/a.mp3" length="123" type="audio/mpeg"/>' +
+    '<description>Text</description><itunes:duration>10:00</itunes:duration></item>' +
+    '<item><title>No date</title><pubDate>June 10, 2003</pubDate></item>' +
+    '</channel></rss>';
+
+var atom = '<feed xmlns="http://www.w3.org/2005/Atom"><title>Atom</title><id>urn:feed</id>' +
+    '<author><name>A</name><email>a@example.com</email></author>' +
+    '<entry><id>urn:1</id><title>One</title><updated>2003-12-13T18:30:02Z</updated>' +
+    '<link rel="alternate" href="http://example.com/1"/><link rel="enclosure" href="http://example.com/1.mp3" length="5"/>' +
+    '<summary>Sum</summary><content type="html">&lt;p&gt;Body&lt;/p&gt;</content></entry>' +
+    '<entry><id>urn:2</id></entry></feed>';
+
+var podcast = '<rss xmlns:itunes="http://www.itunes.com/dtds/podcast-1.0.dtd"><channel>' +
+    '<title>Podcast</title><description>Weekly episodes</description>' +
+    '<itunes:author>Host</itunes:author><itunes:category text="News"><itunes:category text="Daily"/>' +
+    '</itunes:category><itunes:explicit>no</itunes:explicit>' +
+    '<item><title>Episode 1</title><guid>ep-1</guid><pubDate>Tue, 10 Jun 2003 04:00:00 GMT</pubDate>' +
+    '<enclosure url="http://example.com/1.mp3" length="1000" type="audio/mpeg"/>' +
+    '<itunes:duration>01:02:03</itunes:duration><itunes:episode>1</itunes:episode>' +
+    '<itunes:image href="http://example.com/1.jpg"/><description><![CDATA[<p>Show notes</p>]]></description>' +
+    '</item><item><title>Episode 2</title><guid>ep-2</guid><enclosure url="http://example.com/2.mp3"/>' +
+    '<itunes:duration>45:00</itunes:duration></item></channel></rss>';
+
+var nonAscii = '<feed xmlns="http://www.w3.org/2005/Atom"><title>Ünïcödé — 日本語</title><id>urn:ü</id>' +
+    '<entry><id>urn:ü:1</id><title>Grüße aus Köln 🎉</title><updated>2003-12-13T18:30:02Z</updated>' +
+    '<author><name>Zoë</name></author><link href="http://example.com/ü"/>' +
+    '<summary>Привет, мир</summary><content>中文内容 &amp; ελληνικά</content></entry></feed>';
+
+describe('Binary result', function() {
+
+    it('should return an ArrayBuffer', function() {
+        var buffer = parser.parse(rss, { binary: true });
+        assert.ok(buffer instanceof ArrayBuffer);
+        assert.equal(new DataView(buffer).getUint32(0, true), 0x31424646);
+    });
+
+    it('should decode fields on access', function() {
+        var feed = new parser.BinaryFeed(parser.parse(rss, { binary: true, extensions: true }));
+        assert.equal(feed.type, 'rss');
+        assert.equal(feed.title, 'Feed');
+        assert.equal(feed.items.length, 2);
+        assert.equal(feed.items[0].title, 'Ünïcode ✓');
+        assert.equal(feed.items[0].date.getTime(), Date.UTC(2003, 5, 10, 4));
+        assert.equal(feed.items[0].date_raw, 'Tue, 10 Jun 2003 04:00:00 GMT');
+        assert.deepEqual(feed.items[0].categories, [{ name: 'a' }, { name: 'b' }]);
+        assert.deepEqual(feed.items[0].enclosure,
+            { length: 123, type: 'audio/mpeg', url: 'http://example.com/a.mp3' });
+        assert.deepEqual(feed.items[0].extensions, [{ name: 'itunes:duration', value: '10:00' }]);
+        assert.deepEqual(feed.extensions,
+            [{ name: 'itunes:image', value: '', attributes: { href: 'http://example.com/a.jpg' } }]);
+        assert.equal(feed.items[1].description, undefined);
+    });
+
+    it('should decode into the same object as parse', function() {
+        [rss, atom].forEach(function(xml) {
+            var options = { extensions: true };
+            var feed = new parser.BinaryFeed(parser.parse(xml, { binary: true, extensions: true }));
+            assert.deepEqual(feed.toObject(), parser.parse(xml, options));
+        });
+    });
+
+    it('should decode podcast and non-ASCII feeds', function() {
+        [podcast, nonAscii].forEach(function(xml) {
+            var feed = new parser.BinaryFeed(parser.parse(xml, { binary: true, extensions: true }));
+            assert.deepEqual(feed.toObject(), parser.parse(xml, { extensions: true }));
+        });
+    });
+
+    it('should keep the warnings of the lenient mode', function() {
+        var buffer = parser.parse('<rss><channel><item><title>A</item></channel></rss>',
+            { binary: true, lenient: true });
+        var feed = new parser.BinaryFeed(buffer);
+        assert.equal(feed.items[0].title, 'A');
+        assert.ok(feed.warnings.length > 0);
+    });
+
+    it('should work with the async and reusable parsers', function(done) {
+        var reusable = new parser.Parser({ binary: true });
+        assert.equal(new parser.BinaryFeed(reusable.parse(atom)).items[0].title, 'One');
+        parser.parse(atom, { binary: true }, function(err, buffer) {
+            assert.ifError(err);
+            assert.equal(new parser.BinaryFeed(buffer).id, 'urn:feed');
+            done();
+        });
+    });
+
+    it('should reject other buffers', function() {
+        assert.throws(function() {
+            new parser.BinaryFeed(new ArrayBuffer(64));
+        }, /Invalid binary feed/);
+    });
+
+    it('should be transferable from a worker thread', function(done) {
+        var threads;
+        try {
+            threads = require('worker_threads');
+        } catch (err) {
+            this.skip();
+        }
+        var worker = new threads.Worker(
+            'var threads = require("worker_threads");' +
+            'var parser = require(' + JSON.stringify(require.resolve('../')) + ');' +
+            'var buffer = parser.parse(threads.workerData, { binary: true });' +
+            'threads.parentPort.postMessage(buffer, [buffer]);',
+            { eval: true, workerData: atom });
+        worker.on('message', function(buffer) {
+            assert.equal(new parser.BinaryFeed(buffer).items[0].content, '<p>Body</p>');
+            done();
+        });
+        worker.on('error', done);
+    });
+});
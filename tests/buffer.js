@@ -0,0 +1,48 @@
+var assert = require('assert');
+var parser = require('../');
+
+var rss = '<rss><channel><title>Test ÄÖ</title>' +
+    '<item><link>/test</link><description>Desc &amp; more</description></item></channel></rss>';
+
+describe('Buffer input', function() {
+
+    it('should parse a Buffer (sync)', function() {
+        var buffer = Buffer.from(rss, 'utf8');
+        var feed = parser.parse(buffer);
+        assert.equal(feed.title, 'Test ÄÖ');
+        assert.equal(feed.items[0].description, 'Desc & more');
+    });
+
+    it('should not modify the given Buffer', function() {
+        var buffer = Buffer.from(rss, 'utf8');
+        parser.parse(buffer);
+        assert.equal(buffer.toString('utf8'), rss);
+    });
+
+    it('should parse a Uint8Array', function() {
+        var buffer = Buffer.from(rss, 'utf8');
+        var array = new Uint8Array(buffer.buffer, buffer.byteOffset, buffer.length);
+        var feed = parser.parse(array);
+        assert.equal(feed.items[0].link, '/test');
+    });
+
+    it('should parse a slice of a larger Buffer', function() {
+        var buffer = Buffer.from('xxx' + rss + 'yyy', 'utf8');
+        var feed = parser.parse(buffer.slice(3, buffer.length - 3));
+        assert.equal(feed.items[0].link, '/test');
+    });
+
+    it('should parse a Buffer (async)', function(done) {
+        parser.parse(Buffer.from(rss, 'utf8'), function(err, feed) {
+            assert.ifError(err);
+            assert.equal(feed.title, 'Test ÄÖ');
+            done();
+        });
+    });
+
+    it('should parse Buffers in batch', function() {
+        var results = parser.parseMany([Buffer.from(rss, 'utf8'), rss]);
+        assert.equal(results[0].title, 'Test ÄÖ');
+        assert.equal(results[1].title, 'Test ÄÖ');
+    });
+});
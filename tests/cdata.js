@@ -13,6 +13,11 @@ var cdata_mixed = '<feed><title><![CDATA[Hello]]> New <![CDATA[World]]></title><
     '<link>http://example.com/1</link>' +
     '</entry></feed>';
 
+var cdata_content = '<rss><channel><item>' +
+    '<content:encoded><![CDATA[<p>One</p>]]><![CDATA[<p>Two</p>]]></content:encoded>' +
+    '<title>A <![CDATA[&]]> B</title>' +
+    '</item></channel></rss>';
+
 describe('CDATA', function() {
 
     it('should extract CDATA title', function() {
@@ -31,4 +36,11 @@ describe('CDATA', function() {
         var feed = parser.parse(cdata_mixed);
         assert.equal(feed.title, 'Hello New World');
     });
+
+    it('should join CDATA siblings read more than once', function() {
+        var item = parser.parse(cdata_content, { extensions: true }).items[0];
+        assert.equal(item.content, '<p>One</p><p>Two</p>');
+        assert.equal(item.extensions[0].value, '<p>One</p><p>Two</p>');
+        assert.equal(item.title, 'A & B');
+    });
 });
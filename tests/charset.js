@@ -0,0 +1,73 @@
+var assert = require('assert');
+var parser = require('../');
+
+function rss(declaration, title) {
+    return declaration + '<rss><channel><title>' + title + '</title>' +
+        '<item><title>' + title + '</title></item></channel></rss>';
+}
+
+describe('Input charset', function() {
+
+    it('should decode declared ISO-8859-1', function() {
+        var xml = Buffer.from(rss('<?xml version="1.0" encoding="ISO-8859-1"?>', 'Café Ä'), 'latin1');
+        var feed = parser.parse(xml);
+        assert.equal(feed.title, 'Café Ä');
+        assert.equal(feed.items[0].title, 'Café Ä');
+    });
+
+    it('should decode windows-1252 characters', function() {
+        var xml = Buffer.concat([
+            Buffer.from("<?xml version='1.0' encoding='windows-1252'?><rss><channel><title>"),
+            Buffer.from([0x93, 0x61, 0x94, 0x20, 0x80, 0x20, 0x96]),
+            Buffer.from('</title></channel></rss>')
+        ]);
+        assert.equal(parser.parse(xml).title, '“a” € –');
+    });
+
+    it('should decode UTF-16 with the byte order mark', function() {
+        var xml = rss('<?xml version="1.0" encoding="UTF-16"?>', 'Tere 😀 õ');
+        var le = Buffer.concat([Buffer.from([0xFF, 0xFE]), Buffer.from(xml, 'utf16le')]);
+        assert.equal(parser.parse(le).title, 'Tere 😀 õ');
+        var be = Buffer.from(le).swap16();
+        assert.equal(parser.parse(be).title, 'Tere 😀 õ');
+    });
+
+    it('should decode UTF-16 without the byte order mark', function() {
+        var xml = rss('<?xml version="1.0"?>', 'Tere õ');
+        assert.equal(parser.parse(Buffer.from(xml, 'utf16le')).title, 'Tere õ');
+        assert.equal(parser.parse(Buffer.from(xml, 'utf16le').swap16()).title, 'Tere õ');
+    });
+
+    it('should skip the UTF-8 byte order mark', function() {
+        var xml = Buffer.concat([Buffer.from([0xEF, 0xBB, 0xBF]), Buffer.from(rss('', 'Tere õ'))]);
+        assert.equal(parser.parse(xml).title, 'Tere õ');
+    });
+
+    it('should use the charset option over the declaration', function() {
+        var xml = Buffer.from(rss('<?xml version="1.0" encoding="UTF-8"?>', 'Café'), 'latin1');
+        assert.equal(parser.parse(xml, { charset: 'iso-8859-1' }).title, 'Café');
+        xml = Buffer.from(rss('<?xml version="1.0" encoding="ISO-8859-1"?>', 'Café'));
+        assert.equal(parser.parse(xml, { charset: 'UTF-8' }).title, 'Café');
+    });
+
+    it('should work with the reusable parser and parseMany', function(done) {
+        var xml = Buffer.from(rss('<?xml version="1.0" encoding="latin1"?>', 'Café'), 'latin1');
+        assert.equal(new parser.Parser().parse(xml).title, 'Café');
+        parser.parseMany([xml, xml], function(err, results) {
+            assert.ifError(err);
+            assert.equal(results[1].title, 'Café');
+            done();
+        });
+    });
+
+    it('should not transcode strings', function() {
+        var xml = rss('<?xml version="1.0" encoding="ISO-8859-1"?>', 'Café');
+        assert.equal(parser.parse(xml).title, 'Café');
+    });
+
+    it('should throw on an unknown charset', function() {
+        assert.throws(function() {
+            parser.parse(rss('', 'Test'), { charset: 'koi8-r' });
+        }, /Unknown charset: koi8-r/);
+    });
+});
@@ -0,0 +1,127 @@
+var assert = require('assert');
+var zlib = require('zlib');
+var parser = require('../');
+
+var items = '';
+for (var i = 0; i < 200; i++) {
+    items += '<item><title>Item ' + i + '</title><link>/' + i + '</link>' +
+        '<description>Tere õhtust ' + i + '</description></item>';
+}
+var rss = '<?xml version="1.0" encoding="utf-8"?><rss><channel><title>Feed</title>' + items + '</channel></rss>';
+var expected = parser.parse(rss);
+
+describe('Compressed input', function() {
+
+    it('should parse gzip and zlib data', function() {
+        assert.deepEqual(parser.parse(zlib.gzipSync(rss)), expected);
+        assert.deepEqual(parser.parse(zlib.deflateSync(rss)), expected);
+    });
+
+    it('should parse raw deflate data with the compression option', function() {
+        assert.deepEqual(parser.parse(zlib.deflateRawSync(rss), { compression: 'deflate-raw' }), expected);
+        assert.deepEqual(parser.parse(zlib.deflateRawSync(rss), { compression: 'deflate' }), expected);
+    });
+
+    it('should parse concatenated gzip members', function() {
+        var half = Math.floor(rss.length / 2);
+        var xml = Buffer.concat([zlib.gzipSync(rss.slice(0, half)), zlib.gzipSync(rss.slice(half))]);
+        assert.deepEqual(parser.parse(xml), expected);
+    });
+
+    it('should convert the inflated data from its charset', function() {
+        var latin = '<?xml version="1.0" encoding="ISO-8859-1"?><rss><channel><title>Café</title></channel></rss>';
+        assert.equal(parser.parse(zlib.gzipSync(Buffer.from(latin, 'latin1'))).title, 'Café');
+    });
+
+    it('should throw on truncated and corrupt data', function() {
+        var gzip = zlib.gzipSync(rss);
+        assert.throws(function() {
+            parser.parse(gzip.slice(0, gzip.length - 100));
+        }, /unexpected end of compressed data/);
+        var corrupt = Buffer.from(gzip);
+        corrupt.fill(0xFF, 20, 40);
+        assert.throws(function() {
+            parser.parse(corrupt);
+        }, /invalid compressed data/);
+    });
+
+    it('should not trust the size in the gzip trailer', function(done) {
+        var gzip = zlib.gzipSync('<rss><channel><title>Feed</title></channel></rss>');
+        gzip.writeUInt32LE(0xFFFFFFF0, gzip.length - 4);
+        assert.throws(function() {
+            parser.parse(gzip);
+        }, /invalid compressed data/);
+        assert.throws(function() {
+            new parser.Parser().parse(gzip);
+        }, /invalid compressed data/);
+        parser.parseAsync(gzip).then(function() {
+            done(new Error('Expected an error'));
+        }, function(err) {
+            assert.ok(/invalid compressed data/.test(err.message));
+            parser.parseMany([gzip], function(err, results) {
+                assert.ifError(err);
+                assert.ok(results[0] instanceof Error);
+                done();
+            });
+        }).catch(done);
+    });
+
+    it('should read the output pending when the input is used', function() {
+        // With Node's zlib, some of these sizes fill the output
+        // space exactly when the last input byte is used.
+        function check(from, to) {
+            for (var n = from; n < to; n++) {
+                var xml = '<rss><channel><title>' + new Array(n + 1).join('a') + '</title></channel></rss>';
+                var deflated = zlib.deflateRawSync(xml);
+                assert.equal(parser.parse(deflated, { compression: 'deflate-raw' }).title.length, n);
+                var incremental = parser.createIncrementalParser({ compression: 'deflate-raw' });
+                incremental.write(deflated);
+                assert.equal(incremental.end().title.length, n);
+            }
+        }
+        check(4270, 4300);
+        check(23750, 23780);
+    });
+
+    it('should not inflate with compression false', function() {
+        assert.throws(function() {
+            parser.parse(zlib.gzipSync(rss), { compression: false });
+        }, TypeError);
+    });
+
+    it('should work with parseAsync, parseMany and the reusable parser', function(done) {
+        var gzip = zlib.gzipSync(rss);
+        var reusable = new parser.Parser();
+        assert.deepEqual(reusable.parse(gzip), expected);
+        assert.deepEqual(reusable.parse(rss), expected);
+        parser.parseAsync(gzip).then(function(feed) {
+            assert.deepEqual(feed, expected);
+            parser.parseMany([gzip, rss], function(err, results) {
+                assert.ifError(err);
+                assert.deepEqual(results[0], expected);
+                assert.deepEqual(results[1], expected);
+                done();
+            });
+        }).catch(done);
+    });
+
+    it('should inflate streamed chunks', function() {
+        var gzip = zlib.gzipSync(rss);
+        [1, 7, 100, gzip.length].forEach(function(size) {
+            var incremental = parser.createIncrementalParser();
+            for (var i = 0; i < gzip.length; i += size) {
+                incremental.write(gzip.slice(i, i + size));
+            }
+            assert.deepEqual(incremental.end(), expected);
+        });
+    });
+
+    it('should throw on truncated streamed data', function() {
+        var gzip = zlib.gzipSync(rss);
+        var incremental = parser.createIncrementalParser();
+        incremental.write(gzip.slice(0, gzip.length - 4));
+        assert.throws(function() {
+            incremental.end();
+        }, /unexpected end of compressed data/);
+    });
+});
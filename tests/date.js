@@ -0,0 +1,126 @@
+var assert = require('assert');
+var parser = require('../');
+
+function rssWithDate(element, date) {
+    return '<rss><channel><title>Test</title>' +
+        '<item><' + element + '>' + date + '</' + element + '></item>' +
+        '</channel></rss>';
+}
+
+function atomWithDate(element, date) {
+    return '<feed><title>Test</title>' +
+        '<entry><' + element + '>' + date + '</' + element + '></entry>' +
+        '</feed>';
+}
+
+function rssDate(date, options) {
+    return parser.parse(rssWithDate('pubDate', date), options).items[0].date;
+}
+
+var utc = Date.UTC(2003, 5, 10, 4, 0, 0);
+
+var rfc822 = [
+    ['Tue, 10 Jun 2003 04:00:00 GMT', utc],
+    ['Tue, 10 Jun 2003 04:00:00 +0000', utc],
+    ['10 Jun 2003 04:00:00 GMT', utc],
+    ['Tue, 10 Jun 2003 04:00 GMT', utc],
+    ['Tue, 10 Jun 03 04:00:00 GMT', utc],
+    ['Tue, 10 June 2003 04:00:00 GMT', utc],
+    ['Tuesday, 10 Jun 2003 04:00:00 GMT', utc],
+    ['tue, 10 jun 2003 04:00:00 gmt', utc],
+    ['Tue,10 Jun 2003 04:00:00 GMT', utc],
+    ['Tue, 10 Jun 2003 4:00:00 UTC', utc],
+    ['  Tue, 10 Jun 2003 04:00:00 GMT\n', utc],
+    ['Tue, 10 Jun 2003 00:00:00 EDT', utc],
+    ['Tue, 10 Jun 2003 00:00:00 -0400', utc],
+    ['Tue, 10 Jun 2003 00:00:00 -04:00', utc],
+    ['Tue, 10 Jun 2003 06:00:00 CEST', utc],
+    ['Tue, 10 Jun 2003 06:00:00 GMT+0200', utc],
+    ['Tue, 10 Jun 2003 09:30:00 +0530', utc],
+    ['Tue, 10 Jun 2003 09:30:00 IST', utc],
+    ['Mon, 09 Jun 2003 21:00:00 PDT', utc],
+    ['Tue, 10 Jun 2003 04:00:00 -0000 (GMT)', utc],
+    ['Jun 10, 2003 04:00:00 GMT', utc],
+    ['Tue, 10 Jun 2003 04:00:00.250 GMT', utc + 250]
+];
+
+var rfc3339 = [
+    ['2003-06-10T04:00:00Z', utc],
+    ['2003-06-10T04:00:00z', utc],
+    ['2003-06-10t04:00:00Z', utc],
+    ['2003-06-10 04:00:00Z', utc],
+    ['2003-06-10T04:00Z', utc],
+    ['2003-06-10T04:00:00.5Z', utc + 500],
+    ['2003-06-10T04:00:00.123456Z', utc + 123],
+    ['2003-06-10T06:00:00+02:00', utc],
+    ['2003-06-10T06:00:00+0200', utc],
+    ['2003-06-09T23:00:00-05:00', utc],
+    ['2003-06-10', Date.UTC(2003, 5, 10)]
+];
+
+describe('Native date parsing', function() {
+
+    rfc822.forEach(function(test) {
+        it('should parse RFC 822 date ' + JSON.stringify(test[0]), function() {
+            var date = rssDate(test[0]);
+            assert.ok(date instanceof Date);
+            assert.equal(date.getTime(), test[1]);
+        });
+    });
+
+    rfc3339.forEach(function(test) {
+        it('should parse RFC 3339 date ' + JSON.stringify(test[0]), function() {
+            var feed = parser.parse(atomWithDate('updated', test[0]));
+            assert.equal(feed.items[0].date.getTime(), test[1]);
+        });
+    });
+
+    it('should parse dc:date', function() {
+        var feed = parser.parse(rssWithDate('dc:date', '2003-06-10T04:00:00Z'));
+        assert.equal(feed.items[0].date.getTime(), utc);
+    });
+
+    it('should parse published', function() {
+        var feed = parser.parse(atomWithDate('published', '2003-06-10T04:00:00Z'));
+        assert.equal(feed.items[0].date.getTime(), utc);
+    });
+
+    it('should prefer updated over published', function() {
+        var feed = parser.parse('<feed><entry>' +
+            '<published>2001-01-01T00:00:00Z</published>' +
+            '<updated>2003-06-10T04:00:00Z</updated>' +
+            '</entry></feed>');
+        assert.equal(feed.items[0].date.getTime(), utc);
+    });
+
+    it('should fall back to Date.parse for dates without timezone', function() {
+        var date = 'Tue, 10 Jun 2003 04:00:00';
+        assert.equal(rssDate(date).getTime(), Date.parse(date));
+    });
+
+    it('should fall back to Date.parse for three-digit years', function() {
+        var date = 'Tue, 10 Jun 103 04:00:00 GMT';
+        assert.equal(rssDate(date).getTime(), Date.parse(date));
+    });
+
+    it('should give invalid date for garbage', function() {
+        var date = rssDate('not a date');
+        assert.ok(date instanceof Date);
+        assert.ok(isNaN(date.getTime()));
+    });
+
+    it('should give timestamps with the timestamps option', function() {
+        assert.strictEqual(rssDate('Tue, 10 Jun 2003 04:00:00 GMT', { timestamps: true }), utc);
+    });
+
+    it('should give raw dates with the rawDates option', function() {
+        var feed = parser.parse(rssWithDate('pubDate', 'Tue, 10 Jun 2003 04:00:00 GMT'), { rawDates: true });
+        assert.equal(feed.items[0].date.getTime(), utc);
+        assert.equal(feed.items[0].date_raw, 'Tue, 10 Jun 2003 04:00:00 GMT');
+    });
+
+    it('should not give raw dates by default', function() {
+        var feed = parser.parse(rssWithDate('pubDate', 'Tue, 10 Jun 2003 04:00:00 GMT'));
+        assert.equal(typeof feed.items[0].date_raw, 'undefined');
+    });
+});
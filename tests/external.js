@@ -0,0 +1,73 @@
+var assert = require('assert');
+var parser = require('../');
+
+function repeat(text, n) {
+    return new Array(n + 1).join(text);
+}
+
+function rss(description) {
+    return '<rss><channel><title>Feed</title><item><title>Item</title>' +
+        '<description><![CDATA[' + description + ']]></description>' +
+        '<content:encoded>&lt;p&gt;' + description + '</content:encoded></item></channel></rss>';
+}
+
+function atom(content) {
+    return '<feed xmlns="http://www.w3.org/2005/Atom"><title>Feed</title><entry><title>Entry</title>' +
+        '<summary>' + content + '</summary><content>' + content + '</content></entry></feed>';
+}
+
+describe('External strings', function() {
+
+    it('should give the same RSS result as without the option', function() {
+        var xml = rss(repeat('Lorem ipsum ', 10000));
+        assert.deepEqual(parser.parse(xml, { externalStrings: true }), parser.parse(xml));
+        assert.deepEqual(parser.parse(xml, { externalStrings: 16 }), parser.parse(xml));
+    });
+
+    it('should give the same Atom result as without the option', function() {
+        var xml = atom(repeat('Lorem ipsum ', 100));
+        assert.deepEqual(parser.parse(xml, { externalStrings: 16 }), parser.parse(xml));
+    });
+
+    it('should decode non-ASCII content', function() {
+        var text = repeat('Tere õhtust, 日本語 😀 ', 100);
+        var feed = parser.parse(Buffer.from(rss(text)), { externalStrings: 16 });
+        assert.equal(feed.items[0].description, text);
+        assert.equal(feed.items[0].content, '<p>' + text);
+    });
+
+    it('should keep short values as normal strings', function() {
+        var feed = parser.parse(rss('Short'), { externalStrings: 1000 });
+        assert.equal(feed.items[0].description, 'Short');
+        feed = parser.parse(rss('Short'), { externalStrings: false });
+        assert.equal(feed.items[0].description, 'Short');
+    });
+
+    it('should keep values valid after the reusable parser is reused', function() {
+        var reusable = new parser.Parser({ externalStrings: 16 });
+        var first = repeat('First ', 100);
+        var second = repeat('Second ', 100);
+        var feed = reusable.parse(rss(first));
+        reusable.parse(rss(second));
+        reusable.parse(Buffer.from(rss(second)));
+        assert.equal(feed.items[0].description, first);
+        assert.equal(feed.items[0].content, '<p>' + first);
+    });
+
+    it('should work with parseAsync', function() {
+        var text = repeat('Async ', 100);
+        return parser.parseAsync(rss(text), { externalStrings: 16 }).then(function(feed) {
+            assert.equal(feed.items[0].description, text);
+        });
+    });
+
+    it('should work with parseMany', function(done) {
+        var texts = [repeat('One ', 100), repeat('Two ', 100)];
+        parser.parseMany(texts.map(rss), { externalStrings: 16 }, function(err, results) {
+            assert.ifError(err);
+            assert.equal(results[0].items[0].description, texts[0]);
+            assert.equal(results[1].items[0].description, texts[1]);
+            done();
+        });
+    });
+});
@@ -0,0 +1,76 @@
+var assert = require('assert');
+var parser = require('../');
+
+var rss = '<rss><channel><title>Test</title>' +
+    '<item><title>T1</title><guid>1</guid><link>/test</link>' +
+    '<pubDate>Tue, 10 Jun 2003 04:00:00 GMT</pubDate>' +
+    '<author>Author</author><description>Desc</description>' +
+    '<category>Cars</category>' +
+    '<enclosure length="123" url="https://example.com" type="video/wmv"/>' +
+    '<dc:creator>Joe</dc:creator>' +
+    '</item></channel></rss>';
+
+var atom = '<feed><title>Test</title><author><name>Feed author</name></author>' +
+    '<entry><id>1</id><title>T1</title>' +
+    '<link rel="alternate" type="text/html" href="http://example.com/1" />' +
+    '<updated>2003-06-10T04:00:00Z</updated>' +
+    '<author><name>Author</name><uri>http://example.com</uri><email>a@example.com</email></author>' +
+    '<summary>Summary</summary><content>Content</content>' +
+    '</entry></feed>';
+
+describe('Fields option', function() {
+
+    it('should extract only the requested RSS item fields', function() {
+        var feed = parser.parse(rss, { fields: ['id', 'link', 'date'], extensions: true });
+        var item = feed.items[0];
+        assert.deepEqual(Object.keys(item).sort(), ['date', 'id', 'link']);
+        assert.equal(item.id, '1');
+        assert.equal(item.link, '/test');
+        assert.equal(item.date.getTime(), Date.UTC(2003, 5, 10, 4));
+        assert.equal(feed.title, 'Test');
+    });
+
+    it('should extract RSS categories, enclosure and extensions on request', function() {
+        var feed = parser.parse(rss, { fields: ['categories', 'enclosure', 'extensions'], extensions: true });
+        var item = feed.items[0];
+        assert.deepEqual(Object.keys(item).sort(), ['categories', 'enclosure', 'extensions']);
+    });
+
+    it('should extract only the requested Atom item fields', function() {
+        var feed = parser.parse(atom, { fields: ['link', 'author'] });
+        var item = feed.items[0];
+        assert.deepEqual(Object.keys(item).sort(), ['author', 'link']);
+        assert.equal(item.link, 'http://example.com/1');
+        assert.equal(item.author, 'Author');
+        assert.equal(feed.author, 'Feed author');
+    });
+
+    it('should extract Atom author subfields on request', function() {
+        var feed = parser.parse(atom, { fields: ['author_email'] });
+        assert.deepEqual(Object.keys(feed.items[0]), ['author_email']);
+        assert.equal(feed.items[0].author_email, 'a@example.com');
+    });
+
+    it('should extract Atom links array on request', function() {
+        var feed = parser.parse(atom, { fields: ['links'] });
+        assert.deepEqual(Object.keys(feed.items[0]), ['links']);
+        assert.equal(feed.items[0].links[0].href, 'http://example.com/1');
+    });
+
+    it('should combine with the content option', function() {
+        var feed = parser.parse(atom, { fields: ['summary', 'content'], content: false });
+        assert.deepEqual(Object.keys(feed.items[0]), []);
+    });
+
+    it('should throw on unknown fields', function() {
+        assert.throws(function() {
+            parser.parse(rss, { fields: ['foo'] });
+        }, /Unknown field: foo/);
+    });
+
+    it('should throw when fields is not an array', function() {
+        assert.throws(function() {
+            parser.parse(rss, { fields: 'id' });
+        }, TypeError);
+    });
+});
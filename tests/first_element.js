@@ -0,0 +1,38 @@
+var assert = require('assert');
+var parser = require('../');
+
+describe('Repeated elements', function() {
+
+    it('should take the first RSS item element', function() {
+        var xml = '<rss><channel><title>A</title><title>B</title>' +
+            '<item><pubDate>Mon, 06 Sep 2010 00:01:00 +0000</pubDate>' +
+            '<title>First</title><title>Second</title>' +
+            '<enclosure url="http://example.com/1.mp3"/><enclosure url="http://example.com/2.mp3"/>' +
+            '<dc:date>2012-01-01T00:00:00Z</dc:date><guid>1</guid><guid>2</guid></item>' +
+            '</channel></rss>';
+        var feed = parser.parse(xml);
+        assert.equal(feed.title, 'A');
+        var item = feed.items[0];
+        assert.equal(item.title, 'First');
+        assert.equal(item.id, '1');
+        assert.equal(item.enclosure.url, 'http://example.com/1.mp3');
+        // dc:date is preferred to pubDate.
+        assert.equal(item.date.getTime(), Date.UTC(2012, 0, 1));
+    });
+
+    it('should take the first Atom entry element', function() {
+        var xml = '<feed><link href="http://example.com/"/><link href="http://example.com/other"/>' +
+            '<entry><published>2010-01-01T00:00:00Z</published><updated>2011-01-01T00:00:00Z</updated>' +
+            '<author><email>a@example.com</email><name>A</name><name>B</name></author>' +
+            '<author><name>C</name></author>' +
+            '<link href="http://example.com/1" href="http://example.com/2"/></entry></feed>';
+        var feed = parser.parse(xml);
+        assert.equal(feed.link, 'http://example.com/');
+        var item = feed.items[0];
+        assert.equal(item.author, 'A');
+        assert.equal(item.author_email, 'a@example.com');
+        assert.equal(item.link, 'http://example.com/1');
+        // updated is preferred to published.
+        assert.equal(item.date.getTime(), Date.UTC(2011, 0, 1));
+    });
+});
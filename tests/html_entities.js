@@ -0,0 +1,39 @@
+var assert = require('assert');
+var parser = require('../');
+
+var rss = '<rss><channel><title>Caf&eacute;&nbsp;&mdash; news</title>' +
+    '<item><title>A&amp;B &lt;&hellip;&gt; &#233; &unknown; &copy</title>' +
+    '<link href="/a?x=1&amp;y=&rarr;">/a</link>' +
+    '<description><![CDATA[Keep &nbsp; here]]></description>' +
+    '<category>&CounterClockwiseContourIntegral;&nGt;&nvlt;</category></item></channel></rss>';
+
+describe('HTML entities', function() {
+
+    it('should translate named references with the option', function() {
+        var feed = parser.parse(rss, { htmlEntities: true });
+        assert.equal(feed.title, 'Café — news');
+        assert.equal(feed.items[0].title, 'A&B <…> é &unknown; &copy');
+    });
+
+    it('should not translate in CDATA sections', function() {
+        var feed = parser.parse(rss, { htmlEntities: true });
+        assert.equal(feed.items[0].description, 'Keep &nbsp; here');
+    });
+
+    it('should translate references with long and multi-character values', function() {
+        var feed = parser.parse(rss, { htmlEntities: true });
+        assert.equal(feed.items[0].categories[0].name, '∳≫⃒<⃒');
+    });
+
+    it('should keep named references without the option', function() {
+        var feed = parser.parse(rss);
+        assert.equal(feed.title, 'Caf&eacute;&nbsp;&mdash; news');
+    });
+
+    it('should work with the incremental parser', function() {
+        var incremental = parser.createIncrementalParser({ htmlEntities: true });
+        incremental.write(rss.slice(0, 50));
+        incremental.write(rss.slice(50));
+        assert.deepEqual(incremental.end(), parser.parse(rss, { htmlEntities: true }));
+    });
+});
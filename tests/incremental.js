@@ -0,0 +1,100 @@
+var assert = require('assert');
+var parser = require('../');
+
+var rss = '<?xml version="1.0" encoding="utf-8"?>\n' +
+    '<rss version="2.0"><channel><title>Päevaleht</title>' +
+    '<item><title>Üks</title><link>/1</link>' +
+    '<description><![CDATA[<b>]] ]></b> & more]]></description>' +
+    '<category>A</category><category>B</category>' +
+    '<enclosure url="http://example.com/a.mp3" length="12" type="audio/mpeg"/></item>' +
+    '<item><title>Kaks</title><link>/2</link><!-- <item> --></item>' +
+    '</channel></rss>';
+
+var atom = '<feed><title>Atom</title><id>urn:x</id>' +
+    '<entry><title>Entry</title><link href="http://example.com/1"/>' +
+    '<updated>2014-02-03T10:00:00Z</updated></entry></feed>';
+
+// Feeds the input in chunks of the given size.
+
+function parseInChunks(xml, size, options) {
+    var incremental = parser.createIncrementalParser(options);
+    var buffer = Buffer.from(xml);
+    for (var i = 0; i < buffer.length; i += size) {
+        incremental.write(buffer.slice(i, i + size));
+    }
+    return incremental.end();
+}
+
+describe('Incremental parser', function() {
+
+    it('should give the same result as parse for any split', function() {
+        var expected = parser.parse(rss);
+        for (var size = 1; size < 40; size++) {
+            assert.deepEqual(parseInChunks(rss, size), expected);
+        }
+    });
+
+    it('should give the same result for Atom', function() {
+        var expected = parser.parse(atom);
+        for (var size = 1; size < 20; size++) {
+            assert.deepEqual(parseInChunks(atom, size), expected);
+        }
+    });
+
+    it('should keep the feed properties after the items', function() {
+        var xml = '<rss><channel><title>Feed</title>' +
+            '<item><title>One</title></item>\n  <item><title>Two</title></item>' +
+            '<description>After &amp; more</description><link>/feed</link></channel></rss>';
+        var expected = parser.parse(xml);
+        for (var size = 1; size < 40; size++) {
+            assert.deepEqual(parseInChunks(xml, size), expected);
+        }
+        var entries = '<feed><entry><title>Entry</title></entry><title>Atom</title><id>urn:x</id></feed>';
+        assert.deepEqual(parseInChunks(entries, 5), parser.parse(entries));
+    });
+
+    it('should take the items from the first channel only', function() {
+        var xml = '<rss><channel><title>First</title><item><title>One</title></item></channel>' +
+            '<channel><title>Second</title><item><title>Two</title></item></channel></rss>';
+        var expected = parser.parse(xml);
+        assert.equal(expected.items.length, 1);
+        for (var size = 1; size < 40; size++) {
+            assert.deepEqual(parseInChunks(xml, size), expected);
+        }
+        var empty = '<rss><channel><title>First</title></channel>' +
+            '<channel><item><title>Two</title></item></channel></rss>';
+        assert.deepEqual(parseInChunks(empty, 7), parser.parse(empty));
+    });
+
+    it('should accept string chunks and a final chunk', function() {
+        var incremental = parser.createIncrementalParser({ content: false });
+        incremental.write(rss.substring(0, 100));
+        var feed = incremental.end(rss.substring(100));
+        assert.deepEqual(feed, parser.parse(rss, { content: false }));
+    });
+
+    it('should give a feed without items', function() {
+        var xml = '<rss><channel><title>Empty</title></channel></rss>';
+        assert.deepEqual(parseInChunks(xml, 3), parser.parse(xml));
+    });
+
+    it('should throw on missing RSS channel', function() {
+        assert.throws(function() {
+            parseInChunks('<rss></rss>', 3);
+        }, /Invalid RSS channel/);
+    });
+
+    it('should throw on truncated input', function() {
+        assert.throws(function() {
+            parseInChunks(rss.substring(0, rss.length - 5), 7);
+        }, /unexpected end of data/);
+    });
+
+    it('should throw after end', function() {
+        var incremental = parser.createIncrementalParser();
+        incremental.end(atom);
+        assert.throws(function() {
+            incremental.write(atom);
+        }, /ended/);
+    });
+});
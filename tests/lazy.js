@@ -0,0 +1,76 @@
+var assert = require('assert');
+var v8 = require('v8');
+var parser = require('../');
+
+v8.setFlagsFromString('--allow-natives-syntax');
+var hasFastProperties = new Function('object', 'return %HasFastProperties(object);');
+
+var rss = '<rss xmlns:media="http://search.yahoo.com/mrss/"><channel><title>Feed</title>' +
+    '<item><title>First</title><description>Desc &amp; more</description>' +
+    '<content:encoded><![CDATA[<p>Content</p>]]></content:encoded>' +
+    '<media:thumbnail url="/t.png"/></item>' +
+    '<item><title>Second</title></item></channel></rss>';
+
+var atom = '<feed xmlns="http://www.w3.org/2005/Atom"><title>Feed</title>' +
+    '<entry><title>Entry</title><summary>Summary</summary><content>Content ü</content></entry></feed>';
+
+describe('Lazy content', function() {
+
+    it('should give the same RSS result as without the option', function() {
+        var options = { lazy: true, extensions: true };
+        assert.deepEqual(parser.parse(rss, options), parser.parse(rss, { extensions: true }));
+    });
+
+    it('should give the same Atom result as without the option', function() {
+        assert.deepEqual(parser.parse(atom, { lazy: true }), parser.parse(atom));
+    });
+
+    it('should keep the values as enumerable properties', function() {
+        var item = parser.parse(rss, { lazy: true, extensions: true }).items[0];
+        assert.deepEqual(Object.keys(item).sort(),
+            ['content', 'description', 'extensions', 'title']);
+        assert.equal(JSON.stringify(item), JSON.stringify(parser.parse(rss, { extensions: true }).items[0]));
+    });
+
+    it('should keep the key order after access', function() {
+        [false, true].forEach(function(stableShape) {
+            var options = { lazy: true, extensions: true, stableShape: stableShape };
+            var lazy = parser.parse(rss, options).items[0];
+            var plain = parser.parse(rss, { extensions: true, stableShape: stableShape }).items[0];
+            assert.equal(lazy.description, 'Desc & more');
+            assert.equal(lazy.content, '<p>Content</p>');
+            assert.deepEqual(Object.keys(lazy), Object.keys(plain));
+            assert.ok(hasFastProperties(lazy));
+        });
+    });
+
+    it('should return the same value on each access', function() {
+        var item = parser.parse(atom, { lazy: true }).items[0];
+        assert.equal(item.content, 'Content ü');
+        assert.equal(item.content, 'Content ü');
+    });
+
+    it('should allow assigning the values', function() {
+        var item = parser.parse(rss, { lazy: true, extensions: true }).items[0];
+        item.description = 'Changed';
+        item.extensions = [];
+        assert.equal(item.description, 'Changed');
+        assert.deepEqual(item.extensions, []);
+        assert.equal(item.content, '<p>Content</p>');
+    });
+
+    it('should keep values valid after the reusable parser is reused', function() {
+        var reusable = new parser.Parser({ lazy: true });
+        var feed = reusable.parse(rss);
+        reusable.parse(atom);
+        reusable.parse(Buffer.from(atom));
+        assert.equal(feed.items[0].description, 'Desc & more');
+        assert.equal(feed.items[0].content, '<p>Content</p>');
+    });
+
+    it('should work with parseAsync', function() {
+        return parser.parseAsync(atom, { lazy: true }).then(function(feed) {
+            assert.equal(feed.items[0].summary, 'Summary');
+        });
+    });
+});
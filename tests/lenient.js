@@ -0,0 +1,113 @@
+var assert = require('assert');
+var zlib = require('zlib');
+var parser = require('../');
+
+function rss(items) {
+    return '<?xml version="1.0"?><rss><channel><title>Feed &amp; more</title>' + items + '</channel></rss>';
+}
+
+var good = '<item><title>One</title><link>/1</link></item>';
+
+describe('Lenient mode', function() {
+
+    it('should add empty warnings to a valid feed', function() {
+        var feed = parser.parse(rss(good), { lenient: true });
+        assert.deepEqual(feed.warnings, []);
+        assert.equal(feed.items[0].title, 'One');
+        assert.equal(parser.parse(rss(good)).warnings, undefined);
+    });
+
+    it('should close mismatched tags', function() {
+        var xml = rss(good + '<item><title>Two <b>bold</title><link>/2</link></item>');
+        assert.throws(function() {
+            parser.parse(xml);
+        }, TypeError);
+        var feed = parser.parse(xml, { lenient: true });
+        assert.equal(feed.items.length, 2);
+        assert.equal(feed.items[1].link, '/2');
+        assert.deepEqual(feed.warnings, ['Line 1: unclosed element <b>']);
+    });
+
+    it('should drop unexpected end tags', function() {
+        var feed = parser.parse(rss('<item><title>One</title></p><link>/1</link></item>'), { lenient: true });
+        assert.equal(feed.items[0].link, '/1');
+        assert.deepEqual(feed.warnings, ['Line 1: unexpected end tag </p>']);
+    });
+
+    it('should treat stray < and & as text', function() {
+        var xml = rss('<item><title>1 < 2 &#; 3</title></item>');
+        var feed = parser.parse(xml, { lenient: true });
+        assert.equal(feed.items[0].title, '1 < 2 &#; 3');
+        assert.deepEqual(feed.warnings, ['Line 1: unescaped <', 'Line 1: unescaped &']);
+    });
+
+    it('should quote attribute values', function() {
+        var xml = rss('<item><enclosure url=/a.mp3 type="audio/mpeg" length=12 /></item>');
+        var feed = parser.parse(xml, { lenient: true });
+        assert.deepEqual(feed.items[0].enclosure, { url: '/a.mp3', type: 'audio/mpeg', length: 12 });
+        assert.equal(feed.warnings.length, 2);
+    });
+
+    it('should keep the complete items of a truncated feed', function() {
+        var xml = rss(good + good + '<item><title>Three</title><link>/').slice(0, -24);
+        var feed = parser.parse(xml, { lenient: true });
+        assert.equal(feed.title, 'Feed & more');
+        assert.equal(feed.items.length, 2);
+        assert.deepEqual(feed.warnings, ['Line 1: unexpected end of document', 'Line 1: incomplete <item> dropped']);
+    });
+
+    it('should report the line numbers', function() {
+        var xml = '<rss>\n<channel>\n<title>T</title>\n<item>\n<title>A & B</title>\n</item>\n</channel>\n</rs';
+        var feed = parser.parse(xml, { lenient: true });
+        assert.equal(feed.items[0].title, 'A & B');
+        assert.deepEqual(feed.warnings, ['Line 5: unescaped &', 'Line 8: unexpected end of document']);
+    });
+
+    it('should still fail on input that is not a feed', function() {
+        assert.throws(function() {
+            parser.parse('<html><body>', { lenient: true });
+        }, /Invalid feed/);
+    });
+
+    it('should work with the reusable parser and parseAsync', function() {
+        var xml = rss('<item><title>A<br></title></item>');
+        var reusable = new parser.Parser({ lenient: true });
+        assert.equal(reusable.parse(xml).warnings.length, 1);
+        assert.equal(reusable.parse(rss(good)).warnings.length, 0);
+        return parser.parseAsync(xml, { lenient: true }).then(function(feed) {
+            assert.equal(feed.items[0].title, 'A');
+        });
+    });
+
+    it('should repair buffers, compressed and converted input on every path', function(done) {
+        var xml = rss('<item><title>Café &amp; A<br></title></item>');
+        var latin = xml.replace('version="1.0"', 'version="1.0" encoding="ISO-8859-1"');
+        var inputs = [xml, Buffer.from(xml), zlib.gzipSync(xml), Buffer.from(latin, 'latin1'),
+            new Uint8Array(Buffer.from(xml))];
+        var options = { lenient: true };
+        function check(feed) {
+            assert.equal(feed.items[0].title, 'Café & A');
+            assert.deepEqual(feed.warnings, ['Line 1: unclosed element <br>']);
+        }
+        var reusable = new parser.Parser(options);
+        inputs.forEach(function(input) {
+            check(parser.parse(input, options));
+            check(reusable.parse(input));
+        });
+        parser.parseMany(inputs, options).forEach(check);
+        parser.parseMany(inputs, options, function(err, results) {
+            assert.ifError(err);
+            results.forEach(check);
+            Promise.all(inputs.map(function(input) {
+                return parser.parseAsync(input, options);
+            })).then(function(feeds) {
+                feeds.forEach(check);
+                reusable.parse(inputs[1], function(err, feed) {
+                    assert.ifError(err);
+                    check(feed);
+                    done();
+                });
+            }).catch(done);
+        });
+    });
+});
@@ -0,0 +1,80 @@
+var assert = require('assert');
+var parser = require('../');
+
+function rss(n) {
+    return '<rss><channel><title>Feed ' + n + '</title>' +
+        '<item><link>/test/' + n + '</link><description>Desc</description></item>' +
+        '</channel></rss>';
+}
+
+var atom = '<feed><title>Atom</title><entry>' +
+    '<link rel="alternate" type="text/html" href="http://example.com/1" />' +
+    '</entry></feed>';
+
+function inputs() {
+    var xmls = [];
+    for (var i = 0; i < 50; i++) {
+        xmls.push(rss(i));
+    }
+    xmls[10] = '<<<<>';
+    xmls[20] = atom;
+    return xmls;
+}
+
+function check(results) {
+    assert.equal(results.length, 50);
+    results.forEach(function(result, i) {
+        if (i === 10) {
+            assert.ok(result instanceof TypeError);
+        } else if (i === 20) {
+            assert.equal(result.type, 'atom');
+            assert.equal(result.items[0].link, 'http://example.com/1');
+        } else {
+            assert.equal(result.title, 'Feed ' + i);
+            assert.equal(result.items[0].link, '/test/' + i);
+        }
+    });
+}
+
+describe('Batch parsing', function() {
+
+    it('should parse all feeds in input order (sync)', function() {
+        check(parser.parseMany(inputs(), { concurrency: 4 }));
+    });
+
+    it('should parse all feeds in input order (async)', function(done) {
+        parser.parseMany(inputs(), function(err, results) {
+            assert.ifError(err);
+            check(results);
+            done();
+        });
+    });
+
+    it('should parse with a single thread', function() {
+        check(parser.parseMany(inputs(), { concurrency: 1 }));
+    });
+
+    it('should throw on invalid concurrency', function() {
+        [-1, 1.5, '4', NaN, Infinity].forEach(function(concurrency) {
+            assert.throws(function() {
+                parser.parseMany([rss(1)], { concurrency: concurrency });
+            }, /The concurrency option must be a non-negative integer/);
+        });
+    });
+
+    it('should apply options to all feeds', function() {
+        var results = parser.parseMany([rss(1), rss(2)], { content: false });
+        assert.equal(typeof results[0].items[0].description, 'undefined');
+        assert.equal(typeof results[1].items[0].description, 'undefined');
+    });
+
+    it('should accept an empty array', function() {
+        assert.deepEqual(parser.parseMany([]), []);
+    });
+
+    it('should throw when not given an array', function() {
+        assert.throws(function() {
+            parser.parseMany(rss(1));
+        }, TypeError);
+    });
+});
@@ -0,0 +1,60 @@
+var assert = require('assert');
+var parser = require('../');
+
+function rss(n) {
+    var items = '';
+    for (var i = 0; i < n; i++) {
+        items += '<item><title>Item ' + i + '</title><link>/' + i + '</link>' +
+            '<description><![CDATA[Text]]> <![CDATA[ ' + i + ']]></description></item>';
+    }
+    return '<rss><channel><title>Feed ' + n + '</title>' + items + '</channel></rss>';
+}
+
+describe('Reusable parser', function() {
+
+    it('should give the same results as parse', function() {
+        var reusable = new parser.Parser();
+        [10, 2000, 0, 500, 1].forEach(function(n) {
+            var xml = rss(n);
+            assert.deepEqual(reusable.parse(xml), parser.parse(xml));
+            assert.deepEqual(reusable.parse(Buffer.from(xml)), parser.parse(xml));
+        });
+    });
+
+    it('should use the options given to the constructor', function() {
+        var reusable = new parser.Parser({ fields: ['title'], highWaterMark: 0 });
+        var feed = reusable.parse(rss(3));
+        assert.deepEqual(feed.items[2], { title: 'Item 2' });
+        feed = reusable.parse(rss(1000));
+        assert.equal(feed.items.length, 1000);
+    });
+
+    it('should throw on invalid input and recover', function() {
+        var reusable = new parser.Parser();
+        assert.throws(function() {
+            reusable.parse('<rss><channel><item>');
+        }, TypeError);
+        assert.equal(reusable.parse(rss(2)).items.length, 2);
+    });
+
+    it('should parse with callback', function(done) {
+        var reusable = new parser.Parser();
+        reusable.parse(rss(100), function(err, feed) {
+            assert.ifError(err);
+            assert.equal(feed.items[99].description, 'Text 99');
+            reusable.parse('<html/>', function(err) {
+                assert.ok(err instanceof TypeError);
+                assert.equal(err.message, 'Invalid feed.');
+                done();
+            });
+        });
+    });
+
+    it('should throw when busy', function() {
+        var reusable = new parser.Parser();
+        reusable.parse(rss(10), function() {});
+        assert.throws(function() {
+            reusable.parse(rss(10));
+        }, /busy/);
+    });
+});
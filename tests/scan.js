@@ -0,0 +1,44 @@
+var assert = require('assert');
+var parser = require('../');
+
+// Text with the special character at the given
+// position. Covers positions around the 16 and
+// 32 byte blocks of the vectorized scan.
+
+function text(length, position, special) {
+    return 'a'.repeat(position) + special + 'b'.repeat(length - position);
+}
+
+describe('Scanning text', function() {
+
+    it('should find entities at any position', function() {
+        for (var length = 0; length < 70; length++) {
+            for (var position = 0; position <= length; position += 3) {
+                var xml = '<rss><channel><item><title>' + text(length, position, '&amp;') +
+                    '</title><link a=\'' + text(length, position, '&quot;') + '\'>' +
+                    text(length, position, '"') + '</link></item></channel></rss>';
+                var item = parser.parse(xml).items[0];
+                assert.equal(item.title, text(length, position, '&'));
+                assert.equal(item.link, text(length, position, '"'));
+            }
+        }
+    });
+
+    it('should find CDATA and comment ends at any position', function() {
+        for (var length = 0; length < 70; length++) {
+            var position = length % 37;
+            var xml = '<rss><channel><item><!--' + text(length, position, '--') + '-->' +
+                '<description><![CDATA[' + text(length, position, ']]') + ']]></description>' +
+                '<title>' + 'c'.repeat(length) + '</title></item></channel></rss>';
+            var item = parser.parse(xml).items[0];
+            assert.equal(item.description, text(length, position, ']]'));
+            assert.equal(item.title, 'c'.repeat(length));
+        }
+    });
+
+    it('should fail on unterminated CDATA', function() {
+        assert.throws(function() {
+            parser.parse('<rss><channel><item><description><![CDATA[' + 'x]]'.repeat(40));
+        }, /unexpected end of data/);
+    });
+});
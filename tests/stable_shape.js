@@ -0,0 +1,43 @@
+var assert = require('assert');
+var parser = require('../');
+
+var rss = '<rss><channel><title>Test</title>' +
+    '<item><title>T1</title><category>Cars</category>' +
+    '<enclosure length="123" url="https://example.com" type="video/wmv"/></item>' +
+    '<item><link>/test</link><guid>1</guid></item>' +
+    '</channel></rss>';
+
+var atom = '<feed><title>Test</title>' +
+    '<entry><link rel="alternate" href="http://example.com/1" /><title>T1</title></entry>' +
+    '<entry><id>2</id><link>http://example.com/2</link></entry>' +
+    '</feed>';
+
+describe('Stable shape', function() {
+
+    it('should give all RSS items the same keys', function() {
+        var feed = parser.parse(rss, { stableShape: true });
+        assert.deepEqual(Object.keys(feed.items[0]), Object.keys(feed.items[1]));
+        assert.equal(feed.items[0].title, 'T1');
+        assert.equal(feed.items[0].categories[0].name, 'Cars');
+        assert.equal(feed.items[0].enclosure.length, 123);
+        assert.equal(feed.items[1].link, '/test');
+        assert.equal(feed.items[1].id, '1');
+        assert.ok(feed.items[1].hasOwnProperty('enclosure'));
+        assert.equal(typeof feed.items[1].enclosure, 'undefined');
+        assert.equal(typeof feed.items[1].categories, 'undefined');
+    });
+
+    it('should give all Atom items and links the same keys', function() {
+        var feed = parser.parse(atom, { stableShape: true });
+        assert.deepEqual(Object.keys(feed.items[0]), Object.keys(feed.items[1]));
+        assert.deepEqual(Object.keys(feed.items[0].links[0]), Object.keys(feed.items[1].links[0]));
+        assert.equal(feed.items[0].link, 'http://example.com/1');
+        assert.equal(feed.items[1].link, 'http://example.com/2');
+        assert.equal(typeof feed.items[0].id, 'undefined');
+    });
+
+    it('should omit missing properties by default', function() {
+        var feed = parser.parse(rss);
+        assert.ok(!feed.items[1].hasOwnProperty('enclosure'));
+    });
+});
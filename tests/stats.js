@@ -0,0 +1,61 @@
+var assert = require('assert');
+var zlib = require('zlib');
+var parser = require('../');
+
+var rss = '<rss xmlns:itunes="http://www.itunes.com/dtds/podcast-1.0.dtd"><channel>' +
+    '<title>Feed</title><itunes:author>A</itunes:author>' +
+    '<item><title><![CDATA[One]]> <![CDATA[Two]]></title>' +
+    '<itunes:duration>10:00</itunes:duration></item>' +
+    '<item><title>Second</title></item></channel></rss>';
+
+describe('Stats', function() {
+
+    it('should not add stats by default', function() {
+        assert.equal(typeof parser.parse(rss).stats, 'undefined');
+    });
+
+    it('should count the input, nodes and values', function() {
+        var stats = parser.parse(rss, { extensions: true, stats: true }).stats;
+        assert.equal(stats.inputBytes, Buffer.byteLength(rss));
+        // rss, channel, title, text, itunes:author, text, the
+        // first item with title, two CDATA sections, duration
+        // and text, the second item with title and text.
+        assert.equal(stats.nodes, 15);
+        assert.equal(stats.coalesced, 1);
+        assert.equal(stats.items, 2);
+        assert.equal(stats.extensions, 2);
+        assert.ok(stats.poolBytes > 0);
+    });
+
+    it('should measure the phases', function() {
+        var stats = parser.parse(rss, { stats: true }).stats;
+        assert.ok(stats.parseNs > 0);
+        assert.ok(stats.extractNs > 0);
+        assert.ok(stats.buildNs > 0);
+    });
+
+    it('should report the compressed input size', function() {
+        var gzipped = zlib.gzipSync(rss);
+        var stats = parser.parse(gzipped, { stats: true }).stats;
+        assert.equal(stats.inputBytes, gzipped.length);
+        assert.equal(stats.items, 2);
+    });
+
+    it('should work with the async and reusable parsers', function(done) {
+        var reusable = new parser.Parser({ stats: true });
+        assert.equal(reusable.parse(rss).stats.items, 2);
+        assert.equal(reusable.parse(rss).stats.coalesced, 1);
+        parser.parse(rss, { stats: true }, function(err, feed) {
+            assert.ifError(err);
+            assert.equal(feed.stats.items, 2);
+            done();
+        });
+    });
+
+    it('should include the failed parse in the lenient mode', function() {
+        var feed = parser.parse('<rss><channel><item><title>A</item></channel></rss>',
+            { lenient: true, stats: true });
+        assert.equal(feed.stats.items, 1);
+        assert.ok(feed.stats.parseNs > 0);
+    });
+});
@@ -0,0 +1,132 @@
+var assert = require('assert');
+var parser = require('../');
+
+var rss = '<?xml version="1.0"?>\n<!DOCTYPE rss [ <!ENTITY x "y"> ]>\n' +
+    '<rss version="2.0"><channel><title>Stream</title><link>http://example.com</link>' +
+    '<!-- <item><title>Comment</title></item> -->' +
+    '<item><title>First</title><link>/1</link>' +
+    '<description><![CDATA[<p>Text with </item> inside</p>]]></description></item>' +
+    '<item><title a="&gt;">Second</title><link>/2</link><pubDate>Mon, 06 Sep 2010 00:01:00 +0000</pubDate></item>' +
+    '<item/>' +
+    '</channel></rss>';
+
+var atom = '<feed xmlns="http://www.w3.org/2005/Atom"><title>Atom</title>' +
+    '<entry><id>1</id><link rel="alternate" type="text/html" href="http://example.com/1"/></entry>' +
+    '<entry><id>2</id><entry-data>x</entry-data></entry>' +
+    '</feed>';
+
+// Writes the input in chunks of the given size
+// and collects the items.
+
+function streamItems(xml, size, options, cb) {
+    var feedStream = parser.createStream(options);
+    var items = [];
+    var feed;
+    feedStream.on('feed', function(f) {
+        feed = f;
+    });
+    feedStream.on('data', function(item) {
+        items.push(item);
+    });
+    feedStream.on('error', cb);
+    feedStream.on('end', function() {
+        cb(null, feed, items);
+    });
+    var buffer = Buffer.from(xml);
+    for (var i = 0; i < buffer.length; i += size) {
+        feedStream.write(buffer.slice(i, i + size));
+    }
+    feedStream.end();
+}
+
+describe('Streaming parser', function() {
+
+    it('should give the same items for any chunk size', function(done) {
+        var expected = parser.parse(rss);
+        var sizes = [1, 2, 3, 7, 64, rss.length];
+        var pending = sizes.length;
+        sizes.forEach(function(size) {
+            streamItems(rss, size, {}, function(err, feed, items) {
+                assert.ifError(err);
+                assert.equal(feed.type, 'rss');
+                assert.equal(feed.title, 'Stream');
+                assert.equal(feed.link, 'http://example.com');
+                assert.deepEqual(items, expected.items);
+                assert.equal(items.length, 3);
+                if (--pending === 0) {
+                    done();
+                }
+            });
+        });
+    });
+
+    it('should stream Atom entries', function(done) {
+        streamItems(atom, 5, {}, function(err, feed, items) {
+            assert.ifError(err);
+            assert.equal(feed.type, 'atom');
+            assert.equal(feed.title, 'Atom');
+            assert.deepEqual(items, parser.parse(atom).items);
+            assert.equal(items[0].link, 'http://example.com/1');
+            done();
+        });
+    });
+
+    it('should emit the feed without items', function(done) {
+        var xml = '<rss><channel><title>Empty</title></channel></rss>';
+        streamItems(xml, 4, {}, function(err, feed, items) {
+            assert.ifError(err);
+            assert.equal(feed.title, 'Empty');
+            assert.equal(items.length, 0);
+            done();
+        });
+    });
+
+    it('should pass the options', function(done) {
+        streamItems(rss, 10, { fields: ['title'] }, function(err, feed, items) {
+            assert.ifError(err);
+            assert.deepEqual(items[0], { title: 'First' });
+            done();
+        });
+    });
+
+    it('should give an error for an invalid item', function(done) {
+        var xml = '<rss><channel><item><title>Bad</item></channel></rss>';
+        streamItems(xml, 3, {}, function(err) {
+            assert.ok(err instanceof TypeError);
+            done();
+        });
+    });
+
+    it('should give an error for a truncated feed', function(done) {
+        streamItems(rss.substring(0, 200), 16, {}, function(err) {
+            assert.ok(err instanceof TypeError);
+            assert.equal(err.message, 'Error: unexpected end of data');
+            done();
+        });
+    });
+
+    it('should give an error for a non-feed', function(done) {
+        streamItems('<html></html>', 16, {}, function(err) {
+            assert.equal(err.message, 'Invalid feed.');
+            done();
+        });
+    });
+
+    it('should be async iterable', function() {
+        var feedStream = parser.createStream();
+        feedStream.end(rss);
+        var iterator = feedStream[Symbol.asyncIterator]();
+        var titles = [];
+        function next() {
+            return iterator.next().then(function(result) {
+                if (!result.done) {
+                    titles.push(result.value.title);
+                    return next();
+                }
+            });
+        }
+        return next().then(function() {
+            assert.deepEqual(titles, ['First', 'Second', undefined]);
+        });
+    });
+});
@@ -0,0 +1,66 @@
+var assert = require('assert');
+var parser = require('../');
+
+function rss(title) {
+    return Buffer.concat([
+        Buffer.from('<rss><channel><title>'),
+        Buffer.isBuffer(title) ? title : Buffer.from(title),
+        Buffer.from('</title></channel></rss>')
+    ]);
+}
+
+describe('UTF-8 values', function() {
+
+    it('should create ASCII values', function() {
+        var title = 'A long enough ASCII title to use the vector loop';
+        assert.equal(parser.parse(rss(title)).title, title);
+    });
+
+    it('should decode valid multibyte values', function() {
+        ['ÄÖ', 'Ascii prefix longer than sixteen bytes, then ü', '日本語', '😀 ok', 'x€'].forEach(function(title) {
+            assert.equal(parser.parse(rss(title)).title, title);
+        });
+    });
+
+    it('should replace invalid sequences', function() {
+        var invalid = Buffer.from([0x61, 0xFF, 0x62, 0xC3, 0x63, 0xE2, 0x82, 0x64, 0xED, 0xA0, 0x80, 0x65]);
+        assert.equal(parser.parse(rss(invalid)).title, 'a�b�c�d���e');
+    });
+
+    it('should replace each maximal invalid subpart', function() {
+        var invalid = Buffer.from([0xF0, 0x80, 0x80, 0x41, 0xE2, 0x82, 0x42]);
+        assert.equal(parser.parse(rss(invalid)).title, '���A�B');
+    });
+
+    it('should replace a truncated sequence at the end', function() {
+        var invalid = Buffer.from([0x61, 0xF0, 0x9F, 0x98]);
+        assert.equal(parser.parse(rss(invalid)).title, 'a�');
+        invalid = Buffer.from([0x61, 0xE2, 0x82]);
+        assert.equal(parser.parse(rss(invalid)).title, 'a�');
+        invalid = Buffer.from([0x61, 0xC3]);
+        assert.equal(parser.parse(rss(invalid)).title, 'a�');
+    });
+
+    it('should decode like Buffer.toString', function() {
+        var bytes = [0x61, 0x80, 0xBF, 0xC0, 0xC2, 0xC3, 0xA9, 0xE0, 0xA0, 0xED, 0x9F, 0xEF, 0xF0, 0x90, 0xF4,
+            0x8F, 0x90, 0xF5, 0xFF];
+        var seed = 1;
+        for (var i = 0; i < 500; i++) {
+            var value = [];
+            for (var j = 0; j < 12; j++) {
+                seed = (seed * 1103515245 + 12345) % 2147483648;
+                value.push(bytes[seed % bytes.length]);
+            }
+            value = Buffer.from(value);
+            var expected = value.toString();
+            var xml = Buffer.concat([
+                Buffer.from('<rss><channel><title>'), value,
+                Buffer.from('</title><item><description>'), value,
+                Buffer.from('</description></item></channel></rss>')
+            ]);
+            assert.equal(parser.parse(xml).title, expected);
+            assert.equal(parser.parse(xml, { externalStrings: 1 }).items[0].description, expected);
+            assert.equal(new parser.BinaryFeed(parser.parse(xml, { binary: true })).title, expected);
+        }
+    });
+});
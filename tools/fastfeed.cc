@@ -0,0 +1,397 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include "../src/fastfeed.hpp"
+
+// Command line tool. Parses the feed from the file or
+// from the standard input and prints it as JSON in the
+// same shape as the Node module returns it.
+
+using namespace fastfeed;
+
+static const char USAGE[] =
+    "Usage: fastfeed [options] [file]\n"
+    "\n"
+    "Parses the RSS or Atom feed and prints it as JSON.\n"
+    "Reads the standard input when no file is given.\n"
+    "\n"
+    "Options:\n"
+    "  --no-content          skip description, summary and content\n"
+    "  --extensions          extract extension elements\n"
+    "  --fields=a,b,...      item fields to extract\n"
+    "  --charset=name        encoding of the input\n"
+    "  --compression=name    gzip, deflate, deflate-raw or none\n"
+    "  --lenient             repair malformed input\n"
+    "  --html-entities       translate HTML named character references\n"
+    "  --timestamps          print dates as milliseconds since the epoch\n"
+    "  --count               print the number of items only\n";
+
+// Reads the whole file. Returns false when
+// the file cannot be read.
+
+bool readFile(FILE *file, std::vector<char> &out) {
+    char chunk[65536];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        out.insert(out.end(), chunk, chunk + read);
+    }
+    return !ferror(file);
+}
+
+// JSON output into a string.
+
+class JsonWriter {
+public:
+    JsonWriter(bool timestamps) : timestamps(timestamps), first(true) {}
+
+    void begin(char bracket) {
+        separate();
+        out += bracket;
+        first = true;
+    }
+
+    void end(char bracket) {
+        out += bracket;
+        first = false;
+    }
+
+    void key(const char *name) {
+        key(Text(name, strlen(name)));
+    }
+
+    void key(const Text &name) {
+        separate();
+        string(name.data, name.length);
+        out += ':';
+        first = true;
+    }
+
+    // Writes the key and the value when the
+    // value is not missing.
+    void text(const char *name, const Text &value) {
+        text(Text(name, strlen(name)), value);
+    }
+
+    void text(const Text &name, const Text &value) {
+        if (!value.missing()) {
+            key(name);
+            separate();
+            string(value.data, value.length);
+        }
+    }
+
+    void value(const Text &value) {
+        separate();
+        string(value.data, value.length);
+    }
+
+    void number(double value) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.17g", value);
+        separate();
+        out += buffer;
+    }
+
+    void literal(const char *value) {
+        separate();
+        out += value;
+    }
+
+    void date(const Item &item) {
+        if (item.date.missing()) {
+            return;
+        }
+        key("date");
+        if (!item.dateParsed) {
+            value(item.date);
+        } else if (timestamps) {
+            number(item.time);
+        } else {
+            separate();
+            out += '"';
+            out += isoDate(item.time);
+            out += '"';
+        }
+    }
+
+    const std::string &str() const {
+        return out;
+    }
+
+private:
+    void separate() {
+        if (!first) {
+            out += ',';
+        }
+        first = false;
+    }
+
+    void string(const char *data, size_t length) {
+        out += '"';
+        for (size_t i = 0; i < length; i++) {
+            unsigned char c = static_cast<unsigned char>(data[i]);
+            switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char escape[8];
+                    snprintf(escape, sizeof(escape), "\\u%04x", c);
+                    out += escape;
+                } else {
+                    out += static_cast<char>(c);
+                }
+            }
+        }
+        out += '"';
+    }
+
+    static std::string isoDate(double time) {
+        time_t seconds = static_cast<time_t>(floor(time / 1000));
+        int millis = static_cast<int>(time - seconds * 1000.0);
+        struct tm parts;
+        gmtime_r(&seconds, &parts);
+        char buffer[96];
+        snprintf(buffer, sizeof(buffer), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+            parts.tm_year + 1900, parts.tm_mon + 1, parts.tm_mday,
+            parts.tm_hour, parts.tm_min, parts.tm_sec, millis);
+        return buffer;
+    }
+
+    bool timestamps;
+    bool first;
+    std::string out;
+};
+
+void writeAuthor(JsonWriter &json, const Author &author) {
+    json.text("author", author.name);
+    json.text("author_uri", author.uri);
+    json.text("author_email", author.email);
+}
+
+void writeExtensions(JsonWriter &json, const std::vector<FeedExtension> &extensions) {
+    if (extensions.empty()) {
+        return;
+    }
+    json.key("extensions");
+    json.begin('[');
+    for (size_t i = 0; i < extensions.size(); i++) {
+        const FeedExtension &extension = extensions[i];
+        json.begin('{');
+        json.text("name", extension.name);
+        json.text("value", extension.value);
+        if (!extension.attributes.empty()) {
+            json.key("attributes");
+            json.begin('{');
+            for (size_t j = 0; j < extension.attributes.size(); j++) {
+                json.text(extension.attributes[j].first, extension.attributes[j].second);
+            }
+            json.end('}');
+        }
+        json.end('}');
+    }
+    json.end(']');
+}
+
+void writeItem(JsonWriter &json, const Item &item) {
+    json.begin('{');
+    json.text("id", item.id);
+    json.text("title", item.title);
+    json.text("link", item.link);
+    if (!item.links.empty()) {
+        json.key("links");
+        json.begin('[');
+        for (size_t i = 0; i < item.links.size(); i++) {
+            const Link &link = item.links[i];
+            json.begin('{');
+            json.text("rel", link.rel);
+            json.text("href", link.href);
+            json.text("type", link.type);
+            json.text("hreflang", link.hreflang);
+            json.text("title", link.title);
+            json.text("length", link.length);
+            json.text("text", link.text);
+            json.end('}');
+        }
+        json.end(']');
+    }
+    json.date(item);
+    writeAuthor(json, item.author);
+    if (!item.categories.empty()) {
+        json.key("categories");
+        json.begin('[');
+        for (size_t i = 0; i < item.categories.size(); i++) {
+            json.begin('{');
+            json.text("name", item.categories[i]);
+            json.end('}');
+        }
+        json.end(']');
+    }
+    if (item.enclosure.present) {
+        json.key("enclosure");
+        json.begin('{');
+        if (item.enclosure.hasLength) {
+            json.key("length");
+            json.number(item.enclosure.length);
+        }
+        json.text("type", item.enclosure.type);
+        json.text("url", item.enclosure.url);
+        json.end('}');
+    }
+    json.text("description", item.description);
+    json.text("summary", item.summary);
+    json.text("content", item.content);
+    writeExtensions(json, item.extensions);
+    json.end('}');
+}
+
+void writeFeed(JsonWriter &json, const Feed &feed) {
+    json.begin('{');
+    json.key("type");
+    json.literal(feed.atom ? "\"atom\"" : "\"rss\"");
+    json.text("title", feed.title);
+    json.text("id", feed.id);
+    json.text("link", feed.link);
+    json.text("description", feed.description);
+    writeAuthor(json, feed.author);
+    writeExtensions(json, feed.extensions);
+    json.key("items");
+    json.begin('[');
+    for (size_t i = 0; i < feed.items.size(); i++) {
+        writeItem(json, feed.items[i]);
+    }
+    json.end(']');
+    if (!feed.warnings.empty()) {
+        json.key("warnings");
+        json.begin('[');
+        for (size_t i = 0; i < feed.warnings.size(); i++) {
+            json.value(Text(feed.warnings[i].c_str(), feed.warnings[i].size()));
+        }
+        json.end(']');
+    }
+    json.end('}');
+}
+
+// Reads the option value after the '='.
+// Returns 0 when the argument is not the option.
+
+const char *optionValue(const char *arg, const char *name) {
+    size_t length = strlen(name);
+    if (strncmp(arg, name, length) == 0 && arg[length] == '=') {
+        return arg + length + 1;
+    }
+    return 0;
+}
+
+bool readFields(const char *value, unsigned int *fields) {
+    *fields = 0;
+    std::string list(value);
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        unsigned int field = findField(list.substr(start, end - start).c_str());
+        if (field == 0) {
+            fprintf(stderr, "Unknown field: %s\n", list.substr(start, end - start).c_str());
+            return false;
+        }
+        *fields |= field;
+        start = end + 1;
+    }
+    return true;
+}
+
+bool readCompression(const char *value, Compression *compression) {
+    if (strcmp(value, "gzip") == 0) {
+        *compression = COMPRESSION_GZIP;
+    } else if (strcmp(value, "deflate") == 0) {
+        *compression = COMPRESSION_DEFLATE;
+    } else if (strcmp(value, "deflate-raw") == 0) {
+        *compression = COMPRESSION_DEFLATE_RAW;
+    } else if (strcmp(value, "none") == 0) {
+        *compression = COMPRESSION_NONE;
+    } else {
+        fprintf(stderr, "Unknown compression: %s\n", value);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    ParseOptions options;
+    bool timestamps = false;
+    bool count = false;
+    const char *path = 0;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value;
+        if (strcmp(arg, "--no-content") == 0) {
+            options.extractContent = false;
+        } else if (strcmp(arg, "--extensions") == 0) {
+            options.extractExtensions = true;
+        } else if ((value = optionValue(arg, "--fields"))) {
+            if (!readFields(value, &options.fields)) {
+                return 2;
+            }
+        } else if ((value = optionValue(arg, "--charset"))) {
+            options.charset = findCharset(value, strlen(value));
+            if (options.charset == CHARSET_UNKNOWN) {
+                fprintf(stderr, "Unknown charset: %s\n", value);
+                return 2;
+            }
+        } else if ((value = optionValue(arg, "--compression"))) {
+            if (!readCompression(value, &options.compression)) {
+                return 2;
+            }
+        } else if (strcmp(arg, "--lenient") == 0) {
+            options.lenient = true;
+        } else if (strcmp(arg, "--html-entities") == 0) {
+            options.htmlEntities = true;
+        } else if (strcmp(arg, "--timestamps") == 0) {
+            timestamps = true;
+        } else if (strcmp(arg, "--count") == 0) {
+            count = true;
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            fputs(USAGE, stdout);
+            return 0;
+        } else if (arg[0] == '-' && arg[1] != '\0') {
+            fprintf(stderr, "Unknown option: %s\n%s", arg, USAGE);
+            return 2;
+        } else if (!path) {
+            path = arg;
+        } else {
+            fputs(USAGE, stderr);
+            return 2;
+        }
+    }
+    std::vector<char> input;
+    FILE *file = path && strcmp(path, "-") != 0 ? fopen(path, "rb") : stdin;
+    if (!file || !readFile(file, input)) {
+        fprintf(stderr, "Cannot read %s\n", path ? path : "the standard input");
+        return 1;
+    }
+    if (file != stdin) {
+        fclose(file);
+    }
+    FeedParser parser(options);
+    if (!parser.parse(input.empty() ? "" : &input[0], input.size())) {
+        fprintf(stderr, "%s\n", parser.lastError().c_str());
+        return 1;
+    }
+    if (count) {
+        printf("%zu\n", parser.feed().items.size());
+        return 0;
+    }
+    JsonWriter json(timestamps);
+    writeFeed(json, parser.feed());
+    puts(json.str().c_str());
+    return 0;
+}
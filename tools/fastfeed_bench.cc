@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "../src/fastfeed.hpp"
+
+// Microbenchmark of the parsing core without Node.
+// Parses each file repeatedly with a reused parser
+// and reports the throughput and the latency. Run
+// it under perf to profile the parser alone.
+
+using namespace fastfeed;
+
+static const char USAGE[] =
+    "Usage: fastfeed-bench [options] file...\n"
+    "\n"
+    "Options:\n"
+    "  --time=ms             time per file, default 2000\n"
+    "  --no-content          skip description, summary and content\n"
+    "  --extensions          extract extension elements\n"
+    "  --lenient             repair malformed input\n"
+    "  --html-entities       translate HTML named character references\n";
+
+typedef std::chrono::steady_clock Clock;
+
+bool readFile(const char *path, std::vector<char> &out) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    char chunk[65536];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        out.insert(out.end(), chunk, chunk + read);
+    }
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+double percentile(const std::vector<double> &sorted, double p) {
+    size_t index = static_cast<size_t>(ceil(p * sorted.size()));
+    return sorted[index > 0 ? index - 1 : 0];
+}
+
+// Parses the input until the time has passed. Returns
+// false when parsing fails. Samples are in nanoseconds.
+
+bool run(FeedParser &parser, const std::vector<char> &input, double time,
+    std::vector<double> &samples, size_t *items) {
+    Clock::time_point start = Clock::now();
+    samples.clear();
+    *items = 0;
+    while (samples.size() < 10 ||
+        std::chrono::duration<double, std::milli>(Clock::now() - start).count() < time) {
+        Clock::time_point before = Clock::now();
+        if (!parser.parse(&input[0], input.size())) {
+            return false;
+        }
+        samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - before).count());
+        *items += parser.feed().items.size();
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    ParseOptions options;
+    double time = 2000;
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--time=", 7) == 0) {
+            time = atof(arg + 7);
+        } else if (strcmp(arg, "--no-content") == 0) {
+            options.extractContent = false;
+        } else if (strcmp(arg, "--extensions") == 0) {
+            options.extractExtensions = true;
+        } else if (strcmp(arg, "--lenient") == 0) {
+            options.lenient = true;
+        } else if (strcmp(arg, "--html-entities") == 0) {
+            options.htmlEntities = true;
+        } else if (arg[0] == '-') {
+            fputs(USAGE, arg[1] == 'h' || strcmp(arg, "--help") == 0 ? stdout : stderr);
+            return arg[1] == 'h' || strcmp(arg, "--help") == 0 ? 0 : 2;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        fputs(USAGE, stderr);
+        return 2;
+    }
+    printf("%-32s %10s %9s %10s %10s %10s\n", "file", "bytes", "MB/s", "items/s", "p50 us", "p99 us");
+    FeedParser parser(options);
+    for (size_t i = 0; i < paths.size(); i++) {
+        std::vector<char> input;
+        if (!readFile(paths[i], input) || input.empty()) {
+            fprintf(stderr, "Cannot read %s\n", paths[i]);
+            return 1;
+        }
+        std::vector<double> samples;
+        size_t items;
+        // Warm up.
+        if (!run(parser, input, time / 10, samples, &items) || !run(parser, input, time, samples, &items)) {
+            fprintf(stderr, "%s: %s\n", paths[i], parser.lastError().c_str());
+            return 1;
+        }
+        double total = 0;
+        for (size_t j = 0; j < samples.size(); j++) {
+            total += samples[j];
+        }
+        std::sort(samples.begin(), samples.end());
+        const char *name = strrchr(paths[i], '/') ? strrchr(paths[i], '/') + 1 : paths[i];
+        printf("%-32s %10zu %9.1f %10.0f %10.1f %10.1f\n", name, input.size(),
+            input.size() * samples.size() / 1048576.0 / (total / 1e9),
+            items / (total / 1e9),
+            percentile(samples, 0.5) / 1e3, percentile(samples, 0.99) / 1e3);
+    }
+    return 0;
+}